@@ -0,0 +1,691 @@
+#ifndef ASYNC_IO_H
+#define ASYNC_IO_H
+
+/*
+ **************** 异步文件 I/O（io_uring） ****************
+ 设计目标：
+    1. 调用线程只把写操作放进提交队列就返回，不等待磁盘；完成后调用 Completion(结果)，
+       结果为写入的字节数，失败时为 -errno
+    2. Linux 上直接用 io_uring 系统调用（不依赖 liburing）：写操作先在提交队列中暂存，
+       submit() 一次 io_uring_enter 提交整批；完成事件由一个收割线程读取
+    3. 注册缓冲区：启动时向内核注册一组固定缓冲区（IORING_REGISTER_BUFFERS），
+       acquire_buffer() 取得后用 write_fixed() 写出，内核不必每次重新映射用户页；
+       注册缓冲区用完（或注册失败）时退化为堆缓冲区，调用方无需区分
+    4. 完成回调投递到构造时给定的 Executor（例如 ThreadPool::executor()），没有执行器时在收割线程上直接执行
+    5. io_uring 不可用（内核过旧、被 seccomp 禁止、forceFallback）时退化为 pwrite：
+       submit() 把暂存的写操作交给执行器执行；没有执行器时在调用线程上同步执行，
+       设置 Options::fallbackThread 时改由本对象自己的写线程执行（调用线程同样不等待磁盘）
+    6. stats() 统计系统调用次数（io_uring_enter / pwrite）、操作数和字节数，用来衡量批量提交减少的系统调用
+    7. 同一文件的多个写操作可能乱序完成：调用方用显式偏移写入，关闭文件前先 drain() 或等待自己的 IoTracker
+    8. 在途操作数不超过完成队列容量，超过时提交方等待；因此没有执行器时，回调里不应再大量提交新操作
+    9. write_vectored：多个缓冲区按顺序写到连续的文件区间，只占一个操作（IORING_OP_WRITEV / pwritev），
+       一批数据跨越多个缓冲区时不必拆成多个写操作
+   10. 短写时自动续写剩余部分（两种后端一致）；io_uring_enter 提交失败时，未被内核接收的操作转交 pwrite 后端，
+       不会永远停留在在途状态
+*/
+
+#include "Future.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#if defined(__SANITIZE_THREAD__)
+#include <sanitizer/tsan_interface.h>
+#endif
+
+class AsyncIO {
+public:
+    using Completion = UniqueFunction<void(ssize_t)>;   // 参数：写入的字节数，失败时为 -errno
+
+    struct Options {
+        unsigned queueDepth = 256;          // 提交队列深度；在途操作数上限为完成队列大小（2 倍）
+        size_t registeredBuffers = 16;      // 注册缓冲区个数
+        size_t bufferSize = 64 * 1024;      // 每个缓冲区的大小
+        bool forceFallback = false;         // 强制使用 pwrite 后端（测试 / 对比用）
+        bool fallbackThread = false;        // 退化为 pwrite 且没有执行器时，启动一个写线程执行 pwrite
+    };
+
+    // acquire_buffer 返回的缓冲区；index >= 0 表示内核注册过的固定缓冲区
+    struct Buffer {
+        char* data = nullptr;
+        size_t capacity = 0;
+        int index = -1;
+    };
+
+    struct Stats {
+        bool uring;                 // 当前后端是否为 io_uring
+        bool registeredBuffers;     // 固定缓冲区是否注册成功
+        uint64_t submitCalls;       // 提交用的 io_uring_enter 次数（调用方线程）
+        uint64_t waitCalls;         // 等待完成用的 io_uring_enter 次数（收割线程）
+        uint64_t pwriteCalls;       // 退化后端的 pwrite / pwritev 次数
+        uint64_t opsSubmitted;
+        uint64_t opsCompleted;
+        uint64_t opsFailed;
+        uint64_t bytesWritten;
+
+        uint64_t syscalls() const { return submitCalls + waitCalls + pwriteCalls; }
+    };
+
+    AsyncIO() : AsyncIO(Executor{}, Options()) {}
+    explicit AsyncIO(Executor executor) : AsyncIO(executor, Options()) {}
+
+    AsyncIO(Executor executor, const Options& options) : executor_(executor), options_(options) {
+        setupBuffers();
+#if defined(__linux__)
+        if (!options_.forceFallback && setupRing()) {
+            reaper_ = std::thread(&AsyncIO::reapLoop, this);
+        }
+#endif
+        if (!uring() && !executor_ && options_.fallbackThread) {
+            fallbackWriter_ = std::thread(&AsyncIO::fallbackLoop, this);
+        }
+    }
+
+    AsyncIO(const AsyncIO&) = delete;
+    AsyncIO& operator=(const AsyncIO&) = delete;
+
+    // 等待所有在途操作（及其回调）完成后再释放资源
+    ~AsyncIO() {
+        drain();
+        if (fallbackWriter_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(fallbackMtx_);
+                fallbackStop_ = true;
+            }
+            fallbackCv_.notify_one();
+            fallbackWriter_.join();
+        }
+#if defined(__linux__)
+        if (ringFd_ >= 0) {
+            // 收割线程看到 NOP 后退出；NOP 提交失败时置位 stopping_，收割线程在下一次等待前检查到。
+            // 它可能已经阻塞在等待中，所以一直重试提交，直到 NOP 送达或收割线程已经退出
+            stopping_.store(true, std::memory_order_release);
+            while (!reaperExited_.load(std::memory_order_acquire)) {
+                {
+                    std::lock_guard<std::mutex> lock(sqMtx_);
+                    io_uring_sqe* sqe = nextSqeLocked();
+                    sqe->opcode = IORING_OP_NOP;
+                    sqe->user_data = kStopTag;
+                    if (submitLocked()) break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            reaper_.join();
+            teardownRing();
+        }
+#endif
+        std::free(bufferMemory_);
+    }
+
+    // 进程内共享的实例（没有执行器：回调在收割线程 / 退化后端的写线程上执行，回调应当很短）
+    static AsyncIO& instance() {
+        static AsyncIO io(Executor{}, sharedOptions());
+        return io;
+    }
+
+    bool uring() const { return ringFd_ >= 0; }
+
+    // 取一个缓冲区：优先使用空闲的注册缓冲区，用完时分配堆缓冲区；交给 write_fixed 后由本对象回收
+    Buffer acquire_buffer() {
+        {
+            std::lock_guard<std::mutex> lock(bufMtx_);
+            if (!freeBuffers_.empty()) {
+                int index = freeBuffers_.back();
+                freeBuffers_.pop_back();
+                return {bufferMemory_ + static_cast<size_t>(index) * options_.bufferSize, options_.bufferSize, index};
+            }
+        }
+        return {new char[options_.bufferSize], options_.bufferSize, -1};
+    }
+
+    // 归还未使用的缓冲区
+    void release_buffer(Buffer buffer) {
+        if (!buffer.data) return;
+        if (buffer.index < 0) {
+            delete[] buffer.data;
+            return;
+        }
+        std::lock_guard<std::mutex> lock(bufMtx_);
+        freeBuffers_.push_back(buffer.index);
+    }
+
+    // 暂存一个写操作：把 buffer 的前 len 字节写到 fd 的 offset 处；完成后缓冲区自动回收
+    void write_fixed(int fd, Buffer buffer, size_t len, off_t offset, Completion done = {}) {
+        Op* op = new Op{fd, offset, buffer.data, len, {}, buffer, std::move(done), {}, {}};
+        stage(op);
+    }
+
+    // 暂存一个向量写：把每个 (缓冲区, 长度) 依次写到 fd 从 offset 开始的连续区间；完成后缓冲区全部回收，
+    // 回调的结果为总字节数。缓冲区个数不应超过 IOV_MAX
+    void write_vectored(int fd, std::vector<std::pair<Buffer, size_t>> chunks, off_t offset, Completion done = {}) {
+        if (chunks.size() == 1) {
+            write_fixed(fd, chunks[0].first, chunks[0].second, offset, std::move(done));
+            return;
+        }
+        Op* op = new Op{fd, offset, nullptr, 0, {}, {}, std::move(done), {}, {}};
+        op->iov.reserve(chunks.size());
+        op->chained.reserve(chunks.size());
+        for (auto& [buffer, len] : chunks) {
+            op->iov.push_back({buffer.data, len});
+            op->chained.push_back(buffer);
+            op->len += len;
+        }
+        stage(op);
+    }
+
+    // 暂存一个写操作，数据由本对象持有直到完成
+    void write(int fd, std::string data, off_t offset, Completion done = {}) {
+        Op* op = new Op{fd, offset, nullptr, data.size(), std::move(data), {}, std::move(done), {}, {}};
+        op->data = op->owned.data();
+        stage(op);
+    }
+
+    // 暂存一个写操作，data 由调用方保证在完成回调之前有效
+    void write(int fd, const void* data, size_t len, off_t offset, Completion done = {}) {
+        Op* op = new Op{fd, offset, static_cast<const char*>(data), len, {}, {}, std::move(done), {}, {}};
+        stage(op);
+    }
+
+    // 提交所有暂存的写操作：io_uring 后端一次 io_uring_enter，退化后端交给执行器或就地 pwrite
+    void submit() {
+#if defined(__linux__)
+        if (uring()) {
+            std::lock_guard<std::mutex> lock(sqMtx_);
+            submitLocked();
+        }
+#endif
+        runFallbackStaged();
+    }
+
+    // 提交暂存的操作并等待全部完成（包括完成回调）
+    void drain() {
+        submit();
+        std::unique_lock<std::mutex> lock(doneMtx_);
+        doneCv_.wait(lock, [this] { return inflight_.load(std::memory_order_acquire) == 0; });
+    }
+
+    Stats stats() const {
+        return {uring(),
+                buffersRegistered_,
+                submitCalls_.load(std::memory_order_relaxed),
+                waitCalls_.load(std::memory_order_relaxed),
+                pwriteCalls_.load(std::memory_order_relaxed),
+                opsSubmitted_.load(std::memory_order_relaxed),
+                opsCompleted_.load(std::memory_order_relaxed),
+                opsFailed_.load(std::memory_order_relaxed),
+                bytesWritten_.load(std::memory_order_relaxed)};
+    }
+
+private:
+    struct Op {
+        int fd;
+        off_t offset;
+        const char* data;
+        size_t len;
+        std::string owned;      // write(std::string) 时持有数据
+        Buffer buffer;          // write_fixed 时持有缓冲区
+        Completion done;
+        std::vector<iovec> iov;         // 非空时为向量写（data 不使用）
+        std::vector<Buffer> chained;    // write_vectored 时持有的缓冲区
+        size_t written = 0;             // 已写入的字节数（短写后从这里续写）
+        size_t iovFirst = 0;            // 向量写：第一个尚未写完的 iovec
+    };
+
+    // 记录已写入 n 字节：向量写跳过写完的 iovec，并调整第一个未写完的
+    static void advance(Op* op, size_t n) {
+        op->written += n;
+        while (n > 0 && op->iovFirst < op->iov.size()) {
+            iovec& v = op->iov[op->iovFirst];
+            size_t step = std::min(n, v.iov_len);
+            v.iov_base = static_cast<char*>(v.iov_base) + step;
+            v.iov_len -= step;
+            n -= step;
+            if (v.iov_len == 0) ++op->iovFirst;
+        }
+    }
+
+    static constexpr uint64_t kStopTag = 0;     // 析构时提交的 NOP，通知收割线程退出
+
+    static Options sharedOptions() {
+        Options options;
+        options.fallbackThread = true;
+        return options;
+    }
+
+    // 执行退化后端暂存的操作（io_uring 后端下是提交失败、被撤回的操作）：交给执行器、写线程或就地 pwrite
+    void runFallbackStaged() {
+        std::vector<Op*> batch;
+        {
+            std::lock_guard<std::mutex> lock(sqMtx_);
+            batch.swap(fallbackStaged_);
+        }
+        if (batch.empty()) return;
+        if (fallbackWriter_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(fallbackMtx_);
+                fallbackQueue_.insert(fallbackQueue_.end(), batch.begin(), batch.end());
+            }
+            fallbackCv_.notify_one();
+            return;
+        }
+        for (Op* op : batch) {
+            if (executor_) {
+                executor_([this, op] { runFallback(op); });
+            } else {
+                runFallback(op);
+            }
+        }
+    }
+
+    // 在途操作数上限：不超过完成队列容量，避免完成事件溢出
+    size_t maxInflight() const { return uring() ? cqEntries_ : options_.queueDepth * 2; }
+
+    void stage(Op* op) {
+        opsSubmitted_.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::unique_lock<std::mutex> lock(doneMtx_);
+            if (inflight_.load(std::memory_order_relaxed) >= maxInflight()) {
+                lock.unlock();
+                submit();       // 暂存的操作可能就是占满额度的那些，先提交它们再等待
+                lock.lock();
+                doneCv_.wait(lock, [this] { return inflight_.load(std::memory_order_relaxed) < maxInflight(); });
+            }
+            inflight_.fetch_add(1, std::memory_order_relaxed);
+        }
+#if defined(__linux__)
+        if (uring()) {
+            std::lock_guard<std::mutex> lock(sqMtx_);
+            fillSqe(nextSqeLocked(), op);
+            return;
+        }
+#endif
+        std::lock_guard<std::mutex> lock(sqMtx_);
+        fallbackStaged_.push_back(op);
+    }
+
+    // 退化后端：pwrite（向量写用 pwritev）从已写入的位置续写，直到写完或出错
+    void runFallback(Op* op) {
+        ssize_t result = static_cast<ssize_t>(op->written);
+        while (op->written < op->len) {
+            off_t offset = op->offset + static_cast<off_t>(op->written);
+            ssize_t n;
+            if (!op->iov.empty()) {
+                n = ::pwritev(op->fd, op->iov.data() + op->iovFirst, static_cast<int>(op->iov.size() - op->iovFirst),
+                              offset);
+            } else {
+                n = ::pwrite(op->fd, op->data + op->written, op->len - op->written, offset);
+            }
+            pwriteCalls_.fetch_add(1, std::memory_order_relaxed);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                result = n < 0 ? -errno : static_cast<ssize_t>(op->written);
+                break;
+            }
+            advance(op, static_cast<size_t>(n));
+            result = static_cast<ssize_t>(op->written);
+        }
+        complete(op, result, false);
+    }
+
+    // 退化后端的写线程：按提交顺序执行 pwrite，析构时 drain() 之后才退出，队列此时已空
+    void fallbackLoop() {
+        std::vector<Op*> batch;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(fallbackMtx_);
+                fallbackCv_.wait(lock, [this] { return fallbackStop_ || !fallbackQueue_.empty(); });
+                if (fallbackQueue_.empty()) return;
+                batch.swap(fallbackQueue_);
+            }
+            for (Op* op : batch) runFallback(op);
+            batch.clear();
+        }
+    }
+
+    // 回收操作的资源并执行回调；dispatch 为 true 时回调交给执行器
+    void complete(Op* op, ssize_t result, bool dispatch) {
+        opsCompleted_.fetch_add(1, std::memory_order_relaxed);
+        if (result < 0) {
+            opsFailed_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            bytesWritten_.fetch_add(static_cast<uint64_t>(result), std::memory_order_relaxed);
+        }
+        release_buffer(op->buffer);
+        for (Buffer& buffer : op->chained) release_buffer(buffer);
+        Completion done = std::move(op->done);
+        delete op;
+        if (!done) {
+            finishOne();
+        } else if (dispatch && executor_) {
+            executor_([this, done = std::move(done), result]() mutable {
+                done(result);
+                finishOne();
+            });
+        } else {
+            done(result);
+            finishOne();
+        }
+    }
+
+    // 持锁递减并通知：drain() 返回后（例如析构）不会再有线程访问 doneCv_
+    void finishOne() {
+        std::lock_guard<std::mutex> lock(doneMtx_);
+        inflight_.fetch_sub(1, std::memory_order_acq_rel);
+        doneCv_.notify_all();
+    }
+
+    void setupBuffers() {
+        if (options_.registeredBuffers == 0 || options_.bufferSize == 0) return;
+        size_t bytes = options_.registeredBuffers * options_.bufferSize;
+        bytes = (bytes + 4095) / 4096 * 4096;
+        bufferMemory_ = static_cast<char*>(std::aligned_alloc(4096, bytes));
+        if (!bufferMemory_) return;
+        for (size_t i = options_.registeredBuffers; i > 0; --i) freeBuffers_.push_back(static_cast<int>(i - 1));
+    }
+
+#if defined(__linux__)
+    // 建立 io_uring：io_uring_setup + 映射 SQ / CQ 环和 SQE 数组；失败时返回 false（使用退化后端）
+    bool setupRing() {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, options_.queueDepth, &params));
+        if (fd < 0) return false;
+
+        sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMmap) sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+
+        sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqRing_ == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        cqRing_ = singleMmap ? sqRing_
+                             : mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                    IORING_OFF_CQ_RING);
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = cqRing_ == MAP_FAILED ? MAP_FAILED
+                                           : mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                                  fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_) munmap(cqRing_, cqRingSize_);
+            munmap(sqRing_, sqRingSize_);
+            ::close(fd);
+            return false;
+        }
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        char* sq = static_cast<char*>(sqRing_);
+        sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTailPtr_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqEntries_ = params.sq_entries;
+        unsigned* array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        for (unsigned i = 0; i < sqEntries_; ++i) array[i] = i;    // SQE 下标与环位置一一对应
+        sqTail_ = *sqTailPtr_;
+
+        char* cq = static_cast<char*>(cqRing_);
+        cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        cqEntries_ = params.cq_entries;
+        ringFd_ = fd;
+
+        registerBuffers();
+        return true;
+    }
+
+    void registerBuffers() {
+        if (!bufferMemory_) return;
+        std::vector<iovec> iovecs(options_.registeredBuffers);
+        for (size_t i = 0; i < iovecs.size(); ++i) {
+            iovecs[i].iov_base = bufferMemory_ + i * options_.bufferSize;
+            iovecs[i].iov_len = options_.bufferSize;
+        }
+        // 失败（例如超过 RLIMIT_MEMLOCK）时缓冲区仍可使用，只是退化为普通 IORING_OP_WRITE
+        buffersRegistered_ = syscall(__NR_io_uring_register, ringFd_, IORING_REGISTER_BUFFERS, iovecs.data(),
+                                     static_cast<unsigned>(iovecs.size())) == 0;
+    }
+
+    void teardownRing() {
+        munmap(sqes_, sqesSize_);
+        if (cqRing_ != sqRing_) munmap(cqRing_, cqRingSize_);
+        munmap(sqRing_, sqRingSize_);
+        ::close(ringFd_);
+        ringFd_ = -1;
+    }
+
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+        (toSubmit > 0 ? submitCalls_ : waitCalls_).fetch_add(1, std::memory_order_relaxed);
+        return static_cast<int>(syscall(__NR_io_uring_enter, ringFd_, toSubmit, minComplete, flags, nullptr, 0));
+    }
+
+    // 取下一个空闲 SQE（持有 sqMtx_）；提交队列满时先把暂存的操作提交给内核
+    io_uring_sqe* nextSqeLocked() {
+        if (sqTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqEntries_) submitLocked();
+        io_uring_sqe* sqe = &sqes_[sqTail_ & sqMask_];
+        std::memset(sqe, 0, sizeof(*sqe));
+        ++sqTail_;
+        ++staged_;
+        return sqe;
+    }
+
+    // 按操作当前的进度填写 SQE（短写续写时从已写入的位置开始）
+    void fillSqe(io_uring_sqe* sqe, Op* op) {
+        sqe->fd = op->fd;
+        sqe->off = static_cast<uint64_t>(op->offset + static_cast<off_t>(op->written));
+        if (!op->iov.empty()) {
+            sqe->opcode = IORING_OP_WRITEV;
+            sqe->addr = reinterpret_cast<uint64_t>(op->iov.data() + op->iovFirst);
+            sqe->len = static_cast<uint32_t>(op->iov.size() - op->iovFirst);
+        } else {
+            if (op->buffer.index >= 0 && buffersRegistered_) {
+                sqe->opcode = IORING_OP_WRITE_FIXED;    // 续写时地址仍在同一个注册缓冲区内
+                sqe->buf_index = static_cast<uint16_t>(op->buffer.index);
+            } else {
+                sqe->opcode = IORING_OP_WRITE;
+            }
+            sqe->addr = reinterpret_cast<uint64_t>(op->data + op->written);
+            sqe->len = static_cast<uint32_t>(op->len - op->written);
+        }
+        sqe->user_data = reinterpret_cast<uint64_t>(op);
+#if defined(__SANITIZE_THREAD__)
+        __tsan_release(op);     // Op 经内核交给收割线程，TSAN 看不到这条同步路径
+#endif
+    }
+
+    // 提交所有已填写的 SQE；返回 false 表示 io_uring_enter 出错：
+    // 内核没有接收的 SQE 被撤回，其中的写操作移入 fallbackStaged_，由 runFallbackStaged() 用 pwrite 完成
+    bool submitLocked() {
+        if (staged_ == 0) return true;
+        __atomic_store_n(sqTailPtr_, sqTail_, __ATOMIC_RELEASE);
+        while (staged_ > 0) {
+            int n = enter(staged_, 0, 0);
+            if (n < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+                break;
+            }
+            staged_ -= static_cast<unsigned>(n);
+        }
+        if (staged_ == 0) return true;
+
+        // 没有 SQPOLL 时内核只在 io_uring_enter 中读取提交队列，把 tail 退回到内核的 head 即可撤回
+        unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+        for (unsigned i = head; i != sqTail_; ++i) {
+            uint64_t tag = sqes_[i & sqMask_].user_data;
+            if (tag != kStopTag) fallbackStaged_.push_back(reinterpret_cast<Op*>(tag));
+        }
+        sqTail_ = head;
+        __atomic_store_n(sqTailPtr_, sqTail_, __ATOMIC_RELEASE);
+        staged_ = 0;
+        return false;
+    }
+
+    // 收割线程：短写的操作重新提交剩余部分
+    void resubmit(Op* op) {
+        {
+            std::lock_guard<std::mutex> lock(sqMtx_);
+            fillSqe(nextSqeLocked(), op);
+            submitLocked();
+        }
+        runFallbackStaged();
+    }
+
+    // 收割线程：阻塞等待完成事件，逐个回收并执行 / 投递回调
+    void reapLoop() {
+        reapUntilStopped();
+        reaperExited_.store(true, std::memory_order_release);
+    }
+
+    void reapUntilStopped() {
+        while (true) {
+            unsigned head = *cqHead_;
+            unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+            if (head == tail) {
+                if (stopping_.load(std::memory_order_acquire)) return;
+                enter(0, 1, IORING_ENTER_GETEVENTS);
+                continue;
+            }
+            bool stop = false;
+            for (; head != tail; ++head) {
+                io_uring_cqe& cqe = cqes_[head & cqMask_];
+                if (cqe.user_data == kStopTag) {
+                    stop = true;
+                    continue;
+                }
+                Op* op = reinterpret_cast<Op*>(cqe.user_data);
+#if defined(__SANITIZE_THREAD__)
+                __tsan_acquire(op);
+#endif
+                ssize_t result = cqe.res;
+                __atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);     // 先释放 CQE 再执行回调
+                if (result > 0 && op->written + static_cast<size_t>(result) < op->len) {
+                    advance(op, static_cast<size_t>(result));   // 短写：续写剩余部分，操作仍在途
+                    resubmit(op);
+                    continue;
+                }
+                complete(op, result < 0 ? result : static_cast<ssize_t>(op->written) + result, true);
+            }
+            __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+            if (stop) return;
+        }
+    }
+#endif
+
+    Executor executor_;
+    Options options_;
+
+    // 提交队列（受 sqMtx_ 保护）
+    std::mutex sqMtx_;
+    unsigned sqTail_ = 0;
+    unsigned staged_ = 0;                   // 已填写、尚未提交给内核的 SQE 数
+    std::vector<Op*> fallbackStaged_;       // 退化后端暂存的操作
+
+    // 在途操作计数（暂存 + 已提交、回调尚未结束）
+    std::atomic<size_t> inflight_{0};
+    std::mutex doneMtx_;
+    std::condition_variable doneCv_;
+
+    // 缓冲区
+    std::mutex bufMtx_;
+    char* bufferMemory_ = nullptr;
+    std::vector<int> freeBuffers_;
+    bool buffersRegistered_ = false;
+
+    // 退化后端的写线程（Options::fallbackThread）
+    std::thread fallbackWriter_;
+    std::mutex fallbackMtx_;
+    std::condition_variable fallbackCv_;
+    std::vector<Op*> fallbackQueue_;
+    bool fallbackStop_ = false;
+
+    std::thread reaper_;
+    std::atomic<bool> stopping_{false};     // 析构中：完成队列为空时收割线程直接退出
+    std::atomic<bool> reaperExited_{false};
+    int ringFd_ = -1;
+#if defined(__linux__)
+    void* sqRing_ = nullptr;
+    void* cqRing_ = nullptr;
+    size_t sqRingSize_ = 0;
+    size_t cqRingSize_ = 0;
+    size_t sqesSize_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    unsigned* sqHead_ = nullptr;
+    unsigned* sqTailPtr_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned sqEntries_ = 0;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    unsigned cqEntries_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+#endif
+
+    std::atomic<uint64_t> submitCalls_{0};
+    std::atomic<uint64_t> waitCalls_{0};
+    std::atomic<uint64_t> pwriteCalls_{0};
+    std::atomic<uint64_t> opsSubmitted_{0};
+    std::atomic<uint64_t> opsCompleted_{0};
+    std::atomic<uint64_t> opsFailed_{0};
+    std::atomic<uint64_t> bytesWritten_{0};
+};
+
+// 跟踪一组写操作：未完成个数和第一个错误；wait() 等待全部完成
+class IoTracker {
+public:
+    // 为一个写操作生成完成回调；expected 为应写入的字节数，写少了也算失败
+    AsyncIO::Completion track(size_t expected) {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            ++pending_;
+        }
+        return [this, expected](ssize_t result) {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (error_ == 0 && (result < 0 || static_cast<size_t>(result) != expected)) {
+                error_ = result < 0 ? static_cast<int>(-result) : EIO;
+            }
+            if (--pending_ == 0) cv_.notify_all();
+        };
+    }
+
+    // 目前为止是否有写操作失败
+    bool failed() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return error_ != 0;
+    }
+
+    // 等待所有写操作完成，返回第一个错误的 errno（0 表示全部成功）
+    int wait() {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [this] { return pending_ == 0; });
+        return error_;
+    }
+
+private:
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    size_t pending_ = 0;
+    int error_ = 0;
+};
+
+#endif // ASYNC_IO_H
@@ -0,0 +1,408 @@
+#ifndef BINARY_LOG_H
+#define BINARY_LOG_H
+
+/*
+ **************** 二进制日志（延迟格式化） ****************
+ 设计目标：
+    1. 调用点用 LOG_FMT(level, "printf 风格格式串", 参数...)：格式串在调用点第一次执行时登记，得到一个 16 位 ID；
+       之后每次只记录 ID 和参数的紧凑二进制编码，格式化推迟到写入线程，或者根本不做、交给离线解码
+    2. 参数编码：每个参数一个类型标签 + 值；整数用 zigzag / varint 变长编码，浮点数 8 字节，
+       字符串为长度 + 字节（调用时拷贝）；不支持的参数类型在编译期报错
+    3. 二进制日志文件：文件头 + 条目流；某个格式串 ID 在本文件第一次出现时先写字典条目（格式串、源文件、行号），
+       每个文件自包含，可以单独解码；时间戳记录与上一条的差值（zigzag varint）
+    4. 同一套格式化代码既用于写入线程输出文本，也用于离线解码工具 log_decoder
+*/
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include "Timestamp.h"
+
+namespace binlog {
+
+// 日志级别名称，下标与 Logger::Level 一致
+inline const char* levelName(uint8_t level) {
+    static const char* const names[] = {"DEFAULT", "DEBUG", "INFO", "WARNING", "ERROR"};
+    return level < 5 ? names[level] : "UNKNOWN";
+}
+
+// 追加 "YYYY-mm-dd HH:MM:SS.uuuuuu [LEVEL] " 前缀；每个线程一个时间戳缓存，不加锁
+inline void appendPrefix(std::string& out, int64_t timeNs, uint8_t level) {
+    thread_local TimestampCache timestamps;
+    timestamps.append(out, timeNs);
+    out.append(" [");
+    out.append(levelName(level));
+    out.append("] ");
+}
+
+// ---------------- 参数编码 ----------------
+
+enum ArgTag : uint8_t { kInt = 1, kUint = 2, kDouble = 3, kString = 4, kPointer = 5 };
+
+inline void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+inline uint64_t zigzag(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+inline int64_t unzigzag(uint64_t value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+inline bool getVarint(const char*& p, const char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(*p++);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+template<typename>
+inline constexpr bool kUnsupportedArg = false;
+
+inline void encodeString(std::string& out, std::string_view s) {
+    out.push_back(static_cast<char>(kString));
+    putVarint(out, s.size());
+    out.append(s.data(), s.size());
+}
+
+template<typename T>
+void encodeArg(std::string& out, const T& value) {
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same<U, bool>::value) {
+        out.push_back(static_cast<char>(kUint));
+        putVarint(out, value ? 1 : 0);
+    } else if constexpr (std::is_integral<U>::value && std::is_signed<U>::value) {
+        out.push_back(static_cast<char>(kInt));
+        putVarint(out, zigzag(value));
+    } else if constexpr (std::is_integral<U>::value) {
+        out.push_back(static_cast<char>(kUint));
+        putVarint(out, value);
+    } else if constexpr (std::is_enum<U>::value) {
+        out.push_back(static_cast<char>(kInt));
+        putVarint(out, zigzag(static_cast<int64_t>(value)));
+    } else if constexpr (std::is_floating_point<U>::value) {
+        double d = static_cast<double>(value);
+        out.push_back(static_cast<char>(kDouble));
+        out.append(reinterpret_cast<const char*>(&d), sizeof(d));
+    } else if constexpr (std::is_array<T>::value) {
+        encodeString(out, std::string_view(value));
+    } else if constexpr (std::is_same<U, const char*>::value || std::is_same<U, char*>::value) {
+        encodeString(out, value ? std::string_view(value) : std::string_view("(null)"));
+    } else if constexpr (std::is_convertible<const U&, std::string_view>::value) {
+        encodeString(out, std::string_view(value));
+    } else if constexpr (std::is_pointer<U>::value) {
+        out.push_back(static_cast<char>(kPointer));
+        putVarint(out, reinterpret_cast<uintptr_t>(value));
+    } else {
+        static_assert(kUnsupportedArg<U>, "LOG_FMT: unsupported argument type");
+    }
+}
+
+struct Arg {
+    ArgTag tag;
+    int64_t i = 0;
+    uint64_t u = 0;
+    double d = 0;
+    std::string_view s;
+};
+
+// 依次读出编码后的参数
+class ArgReader {
+public:
+    explicit ArgReader(std::string_view data) : p_(data.data()), end_(data.data() + data.size()) {}
+
+    bool next(Arg& arg) {
+        if (p_ >= end_) return false;
+        arg.tag = static_cast<ArgTag>(*p_++);
+        uint64_t v = 0;
+        switch (arg.tag) {
+        case kInt:
+            if (!getVarint(p_, end_, v)) return false;
+            arg.i = unzigzag(v);
+            return true;
+        case kUint:
+        case kPointer:
+            if (!getVarint(p_, end_, v)) return false;
+            arg.u = v;
+            return true;
+        case kDouble:
+            if (end_ - p_ < static_cast<ptrdiff_t>(sizeof(double))) return false;
+            std::memcpy(&arg.d, p_, sizeof(double));
+            p_ += sizeof(double);
+            return true;
+        case kString:
+            if (!getVarint(p_, end_, v) || static_cast<uint64_t>(end_ - p_) < v) return false;
+            arg.s = std::string_view(p_, v);
+            p_ += v;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+};
+
+// 用 snprintf 把一个值按 spec 追加到 out
+template<typename... V>
+void appendFormatted(std::string& out, const char* spec, V... values) {
+    size_t old = out.size();
+    out.resize(old + 64);
+    int n = std::snprintf(&out[old], 65, spec, values...);
+    if (n < 0) n = 0;
+    if (n > 64) {
+        out.resize(old + n);
+        std::snprintf(&out[old], n + 1, spec, values...);
+    }
+    out.resize(old + n);
+}
+
+// printf 风格格式化：支持 flags / 宽度 / 精度，长度修饰符（h、l、ll、z ...）被忽略，
+// 实际宽度由参数的类型标签决定；参数与转换符不匹配时按参数自身的类型输出
+inline void formatMessage(std::string& out, std::string_view format, std::string_view args) {
+    ArgReader reader(args);
+    size_t i = 0;
+    while (i < format.size()) {
+        char c = format[i];
+        if (c != '%') {
+            size_t next = format.find('%', i);
+            if (next == std::string_view::npos) next = format.size();
+            out.append(format.data() + i, next - i);
+            i = next;
+            continue;
+        }
+        if (i + 1 < format.size() && format[i + 1] == '%') {
+            out.push_back('%');
+            i += 2;
+            continue;
+        }
+        // 解析 %[flags][width][.precision][length]conversion
+        char spec[32] = "%";
+        size_t len = 1;
+        size_t j = i + 1;
+        while (j < format.size() && std::strchr("-+ #0", format[j]) && len < 8) spec[len++] = format[j++];
+        while (j < format.size() && format[j] >= '0' && format[j] <= '9' && len < 16) spec[len++] = format[j++];
+        if (j < format.size() && format[j] == '.') {
+            spec[len++] = format[j++];
+            while (j < format.size() && format[j] >= '0' && format[j] <= '9' && len < 24) spec[len++] = format[j++];
+        }
+        while (j < format.size() && std::strchr("hlLqjzt", format[j])) ++j;
+        if (j >= format.size()) {
+            out.append(format.data() + i, format.size() - i);
+            break;
+        }
+        char conv = format[j];
+        i = j + 1;
+
+        Arg arg;
+        if (!reader.next(arg)) {
+            out.append("<missing>");
+            continue;
+        }
+        bool intConv = std::strchr("diouxXc", conv) != nullptr;
+        bool floatConv = std::strchr("fFeEgGaA", conv) != nullptr;
+        switch (arg.tag) {
+        case kInt:
+        case kUint: {
+            if (floatConv) {
+                spec[len++] = conv;
+                spec[len] = '\0';
+                appendFormatted(out, spec, arg.tag == kInt ? static_cast<double>(arg.i) : static_cast<double>(arg.u));
+            } else if (conv == 'c') {
+                spec[len++] = 'c';
+                spec[len] = '\0';
+                appendFormatted(out, spec, static_cast<int>(arg.tag == kInt ? arg.i : static_cast<int64_t>(arg.u)));
+            } else {
+                char ic = intConv ? conv : (arg.tag == kInt ? 'd' : 'u');
+                spec[len++] = 'l';
+                spec[len++] = 'l';
+                spec[len++] = ic;
+                spec[len] = '\0';
+                if (ic == 'd' || ic == 'i') {
+                    appendFormatted(out, spec, static_cast<long long>(arg.tag == kInt ? arg.i : static_cast<int64_t>(arg.u)));
+                } else {
+                    appendFormatted(out, spec,
+                                    static_cast<unsigned long long>(arg.tag == kUint ? arg.u : static_cast<uint64_t>(arg.i)));
+                }
+            }
+            break;
+        }
+        case kDouble:
+            spec[len++] = floatConv ? conv : 'g';
+            spec[len] = '\0';
+            appendFormatted(out, spec, arg.d);
+            break;
+        case kString:
+            if (conv == 's') {
+                // 保留宽度；精度与字符串长度取小者
+                std::string_view s = arg.s;
+                char* dot = std::strchr(spec, '.');
+                if (dot) {
+                    size_t precision = static_cast<size_t>(std::atoi(dot + 1));
+                    if (precision < s.size()) s = s.substr(0, precision);
+                    *dot = '\0';
+                    len = static_cast<size_t>(dot - spec);
+                }
+                std::memcpy(spec + len, ".*s", 4);
+                appendFormatted(out, spec, static_cast<int>(s.size()), s.data());
+            } else {
+                out.append(arg.s.data(), arg.s.size());
+            }
+            break;
+        case kPointer:
+            appendFormatted(out, "%p", reinterpret_cast<void*>(static_cast<uintptr_t>(arg.u)));
+            break;
+        }
+    }
+}
+
+// ---------------- 格式串登记 ----------------
+
+struct FormatInfo {
+    const char* format;
+    const char* file;
+    int line;
+};
+
+// 进程内的格式串表：ID 从 1 开始（0 表示普通文本日志）；按块分配，读取无锁
+class FormatRegistry {
+public:
+    static constexpr size_t kBlockSize = 256;
+    static constexpr size_t kMaxFormats = 65535;
+
+    // 有意不析构：Logger 单例在退出时仍要排空记录、查询格式串，而静态对象的析构顺序不确定
+    static FormatRegistry& instance() {
+        static FormatRegistry* registry = new FormatRegistry;
+        return *registry;
+    }
+
+    uint16_t add(const char* format, const char* file, int line) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        size_t id = count_.load(std::memory_order_relaxed) + 1;
+        if (id > kMaxFormats) return 0;         // 用完了：退化为"无格式"条目
+        std::atomic<FormatInfo*>& block = blocks_[id / kBlockSize];
+        if (!block.load(std::memory_order_relaxed)) block.store(new FormatInfo[kBlockSize], std::memory_order_relaxed);
+        block.load(std::memory_order_relaxed)[id % kBlockSize] = {format, file, line};
+        count_.store(id, std::memory_order_release);
+        return static_cast<uint16_t>(id);
+    }
+
+    const FormatInfo* get(uint16_t id) const {
+        if (id == 0 || id > count_.load(std::memory_order_acquire)) return nullptr;
+        return &blocks_[id / kBlockSize].load(std::memory_order_relaxed)[id % kBlockSize];
+    }
+
+private:
+    FormatRegistry() = default;
+
+    std::mutex mtx_;
+    std::atomic<size_t> count_{0};
+    std::array<std::atomic<FormatInfo*>, kMaxFormats / kBlockSize + 1> blocks_{};
+};
+
+// ---------------- 文件格式 ----------------
+//  文件头：kFileMagic（8 字节）
+//  字典条目：'D' varint(id) varint(line) varint(len) file varint(len) format
+//  格式化条目：'L' varint(zigzag 时间差 ns) u8(level) varint(id) varint(len) 参数编码
+//  文本条目：'T' varint(zigzag 时间差 ns) u8(level) varint(len) text
+
+constexpr char kFileMagic[] = "BINLOG1\n";
+constexpr size_t kFileMagicSize = sizeof(kFileMagic) - 1;
+
+inline void appendDictEntry(std::string& out, uint16_t id, const FormatInfo& info) {
+    std::string_view file(info.file);
+    std::string_view format(info.format);
+    out.push_back('D');
+    putVarint(out, id);
+    putVarint(out, static_cast<uint64_t>(info.line));
+    putVarint(out, file.size());
+    out.append(file.data(), file.size());
+    putVarint(out, format.size());
+    out.append(format.data(), format.size());
+}
+
+inline void appendLogEntry(std::string& out, int64_t timeDelta, uint8_t level, uint16_t id, std::string_view args) {
+    out.push_back('L');
+    putVarint(out, zigzag(timeDelta));
+    out.push_back(static_cast<char>(level));
+    putVarint(out, id);
+    putVarint(out, args.size());
+    out.append(args.data(), args.size());
+}
+
+inline void appendTextEntry(std::string& out, int64_t timeDelta, uint8_t level, std::string_view text) {
+    out.push_back('T');
+    putVarint(out, zigzag(timeDelta));
+    out.push_back(static_cast<char>(level));
+    putVarint(out, text.size());
+    out.append(text.data(), text.size());
+}
+
+// 解码一个二进制日志文件的内容，每条日志调用一次 onLine(文本行，不含换行符)；
+// 返回 false 表示文件头不对或内容被截断（已解码的行仍然输出）
+template<typename OnLine>
+bool decodeFile(std::string_view data, OnLine&& onLine) {
+    if (data.substr(0, kFileMagicSize) != std::string_view(kFileMagic, kFileMagicSize)) return false;
+    const char* p = data.data() + kFileMagicSize;
+    const char* end = data.data() + data.size();
+    std::unordered_map<uint64_t, std::string> formats;
+    int64_t timeNs = 0;
+    std::string line;
+    uint64_t v = 0;
+    while (p < end) {
+        char type = *p++;
+        if (type == 'D') {
+            uint64_t id, fileLine, len;
+            if (!getVarint(p, end, id) || !getVarint(p, end, fileLine) || !getVarint(p, end, len) ||
+                static_cast<uint64_t>(end - p) < len)
+                return false;
+            p += len;   // 源文件名只用于排查，解码时不需要
+            if (!getVarint(p, end, len) || static_cast<uint64_t>(end - p) < len) return false;
+            formats[id].assign(p, len);
+            p += len;
+        } else if (type == 'L' || type == 'T') {
+            if (!getVarint(p, end, v) || p >= end) return false;
+            timeNs += unzigzag(v);
+            uint8_t level = static_cast<uint8_t>(*p++);
+            line.clear();
+            appendPrefix(line, timeNs, level);
+            if (type == 'T') {
+                if (!getVarint(p, end, v) || static_cast<uint64_t>(end - p) < v) return false;
+                line.append(p, v);
+                p += v;
+            } else {
+                uint64_t id, len;
+                if (!getVarint(p, end, id) || !getVarint(p, end, len) || static_cast<uint64_t>(end - p) < len)
+                    return false;
+                auto it = formats.find(id);
+                if (it == formats.end()) {
+                    line.append("<unknown format ").append(std::to_string(id)).append(">");
+                } else {
+                    formatMessage(line, it->second, std::string_view(p, len));
+                }
+                p += len;
+            }
+            onLine(std::string_view(line));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace binlog
+
+#endif // BINARY_LOG_H
@@ -0,0 +1,247 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+/*
+ **************** 协程任务（C++20） ****************
+ 设计目标：
+    1. CoTask<T>：惰性启动的协程任务，被 co_await 时才开始执行，完成后通过对称转移直接恢复等待方，
+       不经过线程池队列，调用链再深也不会增长线程栈
+    2. 挂起中的协程只占一个协程帧（从任务内存池分配），不占用线程：
+       co_await pool.schedule() 切换到工作线程，co_await pool.sleep_for(d) 由时间轮到期后恢复，
+       co_await future 在 Future 就绪后由其执行器恢复
+    3. sync_wait(task) 在普通线程中阻塞等待协程结果；co_spawn(pool, task) 把协程放到线程池上运行并返回 Future
+    4. 异常在 co_await 处重新抛出，与同步代码一致
+ 命名为 CoTask 以区别于 ThreadPool::Task（线程池内部的任务类型）
+ 注意：线程池析构时仍在 sleep_for 中挂起的协程不会再被恢复
+ 编译：g++ -std=c++20 -pthread ...
+*/
+
+#if !defined(__cpp_impl_coroutine)
+#error "Coroutine.h requires C++20 coroutines (-std=c++20)"
+#endif
+
+#include "ThreadPool.h"
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+template<typename T = void>
+class CoTask;
+
+namespace detail {
+
+// 协程帧从任务内存池分配（按大小分级复用），挂起数万个协程时也不频繁调用 malloc
+struct CoFrameAllocation {
+    static void* operator new(size_t size) { return TaskMemoryPool::allocate(size); }
+    static void operator delete(void* p, size_t size) noexcept { TaskMemoryPool::deallocate(p, size); }
+};
+
+// 结束时恢复等待方（对称转移）；没有等待方时停在终点，由 CoTask 析构时销毁协程帧
+struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+
+    template<typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+        std::coroutine_handle<> continuation = handle.promise().continuation;
+        return continuation ? continuation : std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept {}
+};
+
+struct CoPromiseBase : CoFrameAllocation {
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+};
+
+template<typename T>
+struct CoPromise : CoPromiseBase {
+    CoTask<T> get_return_object() noexcept;
+
+    template<typename U>
+    void return_value(U&& value) { result.emplace(std::forward<U>(value)); }
+
+    T take() {
+        if (error) std::rethrow_exception(error);
+        return std::move(*result);
+    }
+
+    std::optional<T> result;
+};
+
+template<>
+struct CoPromise<void> : CoPromiseBase {
+    CoTask<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+
+    void take() {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+// 立即开始、结束后自行销毁的协程，用于 sync_wait / co_spawn 的驱动
+struct DetachedCoroutine {
+    struct promise_type : CoFrameAllocation {
+        DetachedCoroutine get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }   // 驱动协程内部已捕获所有异常
+    };
+};
+
+} // namespace detail
+
+template<typename T>
+class [[nodiscard]] CoTask {
+public:
+    using promise_type = detail::CoPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    CoTask() noexcept = default;
+    explicit CoTask(Handle handle) noexcept : handle_(handle) {}
+
+    CoTask(CoTask&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    CoTask& operator=(CoTask&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    CoTask(const CoTask&) = delete;
+    CoTask& operator=(const CoTask&) = delete;
+
+    ~CoTask() {
+        if (handle_) handle_.destroy();
+    }
+
+    bool valid() const noexcept { return static_cast<bool>(handle_); }
+
+    // co_await task：启动（或继续）task，完成后恢复当前协程并取得结果
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            Handle handle;
+
+            bool await_ready() const noexcept { return !handle || handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;      // 对称转移：直接切换到被等待的协程
+            }
+            T await_resume() {
+                if (!handle) throw std::runtime_error("co_await on empty CoTask");
+                return handle.promise().take();
+            }
+        };
+        return Awaiter{handle_};
+    }
+
+    auto operator co_await() & noexcept {
+        return std::move(*this).operator co_await();
+    }
+
+private:
+    Handle handle_;
+};
+
+namespace detail {
+
+template<typename T>
+CoTask<T> CoPromise<T>::get_return_object() noexcept {
+    return CoTask<T>(std::coroutine_handle<CoPromise<T>>::from_promise(*this));
+}
+
+inline CoTask<void> CoPromise<void>::get_return_object() noexcept {
+    return CoTask<void>(std::coroutine_handle<CoPromise<void>>::from_promise(*this));
+}
+
+} // namespace detail
+
+// co_await future：不阻塞线程，Future 就绪后由其执行器（通常是线程池）恢复协程
+template<typename T>
+struct FutureAwaiter {
+    Future<T> future;
+
+    bool await_ready() const { return future.ready(); }
+    void await_suspend(std::coroutine_handle<> handle) {
+        auto* state = future.state_.get();
+        Executor executor = state->executor();
+        state->subscribe([handle, executor] {
+            executor([handle] { handle.resume(); });
+        });
+    }
+    T await_resume() { return future.get(); }
+};
+
+template<typename T>
+FutureAwaiter<T> operator co_await(Future<T>&& future) {
+    if (!future.valid()) throw std::future_error(std::future_errc::no_state);
+    return FutureAwaiter<T>{std::move(future)};
+}
+
+// 在当前线程阻塞等待协程完成并返回结果（或重新抛出异常）；不要在工作线程中调用
+template<typename T>
+T sync_wait(CoTask<T> task) {
+    struct Event {
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool done = false;
+    } event;
+    std::optional<detail::Stored<T>> result;
+    std::exception_ptr error;
+
+    [](CoTask<T>& task, Event& event, std::optional<detail::Stored<T>>& result,
+       std::exception_ptr& error) -> detail::DetachedCoroutine {
+        try {
+            if constexpr (std::is_void<T>::value) {
+                co_await task;
+                result.emplace();
+            } else {
+                result.emplace(co_await task);
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(event.mtx);   // 持锁通知：等待方返回前 event 不会被销毁
+        event.done = true;
+        event.cv.notify_one();
+    }(task, event, result, error);
+
+    std::unique_lock<std::mutex> lock(event.mtx);
+    event.cv.wait(lock, [&event] { return event.done; });
+    if (error) std::rethrow_exception(error);
+    if constexpr (!std::is_void<T>::value) return std::move(*result);
+}
+
+// 在线程池上运行协程，返回它的 Future（可继续 then / when_all，或在另一个协程中 co_await）
+template<typename T>
+Future<T> co_spawn(ThreadPool& pool, CoTask<T> task) {
+    Promise<T> promise(pool.executor());
+    Future<T> result = promise.get_future();
+    [](ThreadPool& pool, CoTask<T> task, Promise<T> promise) -> detail::DetachedCoroutine {
+        try {
+            co_await pool.schedule();
+            if constexpr (std::is_void<T>::value) {
+                co_await task;
+                promise.set_value();
+            } else {
+                promise.set_value(co_await task);
+            }
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+        }
+    }(pool, std::move(task), std::move(promise));
+    return result;
+}
+
+#endif // COROUTINE_H
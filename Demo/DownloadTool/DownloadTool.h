@@ -7,21 +7,31 @@
     1. 封装 libcurl（进行 HTTP 下载），使用 ThreadPool 提交异步任务
     2. 提供下载字节数、时间、速度和进度信息
     3. 捕获 libcurl 错误和网络异常，通过 Logger 记录关键事件（开始、进度、完成、错误）
+    4. 可取消：download() 接受 StopToken，进度回调发现取消请求后返回非 0 中止传输，删除未完成的文件；
+       一个实例同一时间只能执行一个下载（curl 句柄不能跨线程共享），并发下载需各自创建实例
+    5. 异步写盘（AsyncIO.h）：收到的数据拷贝进注册缓冲区，攒满一个缓冲区才提交一次异步写，
+       curl 回调线程不等待磁盘；下载结束时等待本次下载的所有写完成再关闭文件。
+       构造时可传入共享的 AsyncIO（例如带 I/O 线程池执行器的实例），默认使用 AsyncIO::instance()；
+       执行器不应是运行下载任务的线程池：下载任务等待写完成时，完成回调可能排在同一个池里无人执行
 */
 
 #include "Logger.h"
 #include "DownloadObserver.h"
+#include "StopToken.h"
+#include "AsyncIO.h"
 #include <curl/curl.h>
 #include <string>
 #include <chrono>
 #include <stdexcept>
 #include <sstream>
 #include <iomanip>
-#include <fstream>
 #include <filesystem>
 #include <vector>
 #include <algorithm>
 #include <memory>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
 
 class DownloadTool
 {
@@ -33,9 +43,12 @@ public:
         double speedMbps;       // 下载速度（MB/s）
         bool success;           // 是否成功
         std::string error;      // 错误信息（如果失败）
+        bool cancelled = false; // 是否因取消而中止
     };
 
-    DownloadTool() : curl_(nullptr)
+    DownloadTool() : DownloadTool(AsyncIO::instance()) {}
+
+    explicit DownloadTool(AsyncIO &io) : curl_(nullptr), io_(&io)
     {
         curl_ = curl_easy_init(); // 创建并初始化一个easy句柄（CURL句柄）
         if (!curl_)
@@ -69,19 +82,24 @@ public:
         );
     }
 
-    // 下载函数：执行 HTTP 下载，保存到文件，返回结果
-    DownloadResult download(const std::string &url, const std::string &outputFile = "")
+    // 下载函数：执行 HTTP 下载，保存到文件，返回结果；token 被取消时尽快中止并返回 cancelled
+    DownloadResult download(const std::string &url, const std::string &outputFile = "", StopToken token = {})
     {
         // 确定输出文件名
         std::string finalOutput = outputFile.empty() ? extractFileName(url) : outputFile;
+
+        if (token.stop_requested()) {
+            Logger::getInstance().log(Logger::Level::INFO, "Download cancelled before start: " + url);
+            return {0, 0, 0, false, "Download cancelled", true};
+        }
         
         // 通知开始下载
         notifyDownloadStarted(url);
         Logger::getInstance().log(Logger::Level::INFO, "Starting download: " + url + " to " + finalOutput);
 
         // 打开输出文件
-        outFile_.open(finalOutput, std::ios::binary);
-        if (!outFile_.is_open()) {
+        fd_ = ::open(finalOutput.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
             std::string error = "Failed to open output file: " + finalOutput;
             notifyDownloadError(url, error);
             Logger::getInstance().log(Logger::Level::ERROR, error);
@@ -102,16 +120,44 @@ public:
         
         currentUrl_ = url; // 保存当前URL用于回调
         bytesDownloaded_ = 0;
+        fileOffset_ = 0;
         lastProgress_ = -1.0;
+        lastSpeedTime_ = start;
+        lastSpeedBytes_ = 0;
+        token_ = std::move(token);
+        IoTracker writes;
+        writes_ = &writes;
         
         // 执行下载
         CURLcode res = curl_easy_perform(curl_);
-        outFile_.close();
+        flushChunk();
+        int writeError = writes.wait(); // 等待本次下载的异步写全部完成
+        writes_ = nullptr;
+        ::close(fd_);
+        fd_ = -1;
+        bool cancelled = token_.stop_requested() && res == CURLE_ABORTED_BY_CALLBACK;
+        token_ = StopToken();
         
         auto end = std::chrono::steady_clock::now();
         double duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() / 1000.0;
         double speedMbps = (bytesDownloaded_ / (1024.0 * 1024.0)) / duration;
 
+        if (cancelled) {
+            std::error_code ec;
+            std::filesystem::remove(finalOutput, ec);   // 不留下不完整的文件
+            std::string error = "Download cancelled: " + url;
+            Logger::getInstance().log(Logger::Level::INFO, error);
+            notifyDownloadError(url, error);
+            return {bytesDownloaded_, duration, speedMbps, false, error, true};
+        }
+
+        if (res == CURLE_OK && writeError != 0) {
+            std::string error = "Failed to write output file: " + std::string(std::strerror(writeError));
+            Logger::getInstance().log(Logger::Level::ERROR, error);
+            notifyDownloadError(url, error);
+            return {bytesDownloaded_, duration, speedMbps, false, error};
+        }
+
         if (res != CURLE_OK) {
             std::string error = "Download failed: " + std::string(curl_easy_strerror(res));
             Logger::getInstance().log(Logger::Level::ERROR, error);
@@ -132,10 +178,18 @@ public:
 
 private:
     CURL *curl_;             // curl 句柄
-    std::ofstream outFile_;  // 输出文件流
+    AsyncIO *io_;            // 异步写盘（不持有，须比本对象活得久）
+    int fd_ = -1;            // 输出文件
+    AsyncIO::Buffer chunk_;  // 正在填充的写缓冲区
+    size_t chunkUsed_ = 0;   // chunk_ 中已填充的字节数
+    off_t fileOffset_ = 0;   // 下一次异步写的文件偏移
+    IoTracker *writes_ = nullptr; // 本次下载的异步写
     size_t bytesDownloaded_; // 下载字节数
     double lastProgress_;    // 上次进度（避免重复日志）
     std::string currentUrl_; // 当前下载URL
+    std::chrono::steady_clock::time_point lastSpeedTime_; // 上次计算速度的时间
+    curl_off_t lastSpeedBytes_ = 0; // 上次计算速度时已下载的字节数
+    StopToken token_;        // 当前下载的取消令牌
     std::vector<std::shared_ptr<DownloadObserver>> observers_; // 观察者列表
 
     // 通知观察者下载开始
@@ -178,14 +232,42 @@ private:
         return url.substr(lastSlash + 1);
     }
 
-    // 写入回调：将数据写入文件
+    // 把当前缓冲区提交为一次异步写
+    void flushChunk()
+    {
+        if (chunkUsed_ == 0) {
+            io_->release_buffer(chunk_);
+        } else {
+            io_->write_fixed(fd_, chunk_, chunkUsed_, fileOffset_, writes_->track(chunkUsed_));
+            io_->submit();
+            fileOffset_ += chunkUsed_;
+        }
+        chunk_ = {};
+        chunkUsed_ = 0;
+    }
+
+    // 写入回调：将数据拷贝进写缓冲区，攒满后异步写入文件
     static size_t writeCallback(void *contents, size_t size, size_t nmemb, void *userp)
     {
         DownloadTool *tool = static_cast<DownloadTool *>(userp);
         size_t totalSize = size * nmemb;
-        tool->outFile_.write(static_cast<char *>(contents), totalSize);
-        if (!tool->outFile_) {
-            return 0;  // 表示写入错误
+        if (tool->writes_->failed()) {
+            return 0;  // 之前的异步写失败，表示写入错误
+        }
+        const char *data = static_cast<const char *>(contents);
+        size_t remaining = totalSize;
+        while (remaining > 0) {
+            if (!tool->chunk_.data) {
+                tool->chunk_ = tool->io_->acquire_buffer();
+            }
+            size_t n = std::min(remaining, tool->chunk_.capacity - tool->chunkUsed_);
+            std::memcpy(tool->chunk_.data + tool->chunkUsed_, data, n);
+            tool->chunkUsed_ += n;
+            data += n;
+            remaining -= n;
+            if (tool->chunkUsed_ == tool->chunk_.capacity) {
+                tool->flushChunk();
+            }
         }
         tool->bytesDownloaded_ += totalSize;
         return totalSize;
@@ -195,21 +277,21 @@ private:
     static int progressCallback(void *clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t, curl_off_t)
     {
         DownloadTool *tool = static_cast<DownloadTool *>(clientp);
+        if (tool->token_.stop_requested()) {
+            return 1;  // 中止传输，curl_easy_perform 返回 CURLE_ABORTED_BY_CALLBACK
+        }
         if (dltotal > 0) {
             double progress = static_cast<double>(dlnow) / static_cast<double>(dltotal) * 100.0;
             
-            // 计算速度 (简单实现)
-            static auto lastTime = std::chrono::steady_clock::now();
-            static curl_off_t lastBytes = 0;
-            
+            // 计算速度 (简单实现)；状态放在实例里，多个下载并发时互不干扰
             auto now = std::chrono::steady_clock::now();
-            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastTime).count() / 1000.0;
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - tool->lastSpeedTime_).count() / 1000.0;
             
             double speed = 0;
             if (duration > 0.1) {  // 至少经过0.1秒才更新速度
-                speed = (dlnow - lastBytes) / (1024.0 * 1024.0) / duration; // MB/s
-                lastTime = now;
-                lastBytes = dlnow;
+                speed = (dlnow - tool->lastSpeedBytes_) / (1024.0 * 1024.0) / duration; // MB/s
+                tool->lastSpeedTime_ = now;
+                tool->lastSpeedBytes_ = dlnow;
             }
             
             // 按10%的步长记录进度
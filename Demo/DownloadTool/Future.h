@@ -0,0 +1,520 @@
+#ifndef FUTURE_H
+#define FUTURE_H
+
+/*
+ **************** 可组合的 Future ****************
+ 设计目标：
+    1. Promise / Future：结果就绪时直接触发后续动作，而不是让某个线程阻塞在 get() 上
+    2. then(f)：上游完成后把 f 提交到执行器（线程池）运行，返回新的 Future；f 返回 Future 时自动展开
+       recover(f)：上游失败时用 f(exception_ptr) 的结果代替，成功时原样传递
+    3. when_all / when_any：一组 Future 全部 / 任一完成时就绪，只在完成的线程上做计数，不占用线程等待
+    4. 上游异常沿链路传递，跳过中间的 then，直到被 recover 处理或在 get() 时重新抛出
+    5. 共享状态通过 RecyclingAllocator 分配，复用任务内存池中的内存块
+ Future 只可移动、只能消费一次（get / then / when_* 之后不再有效）
+*/
+
+#include "Task.h"
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 执行器：把任务交给某个线程池运行（类型擦除，Future 不依赖 ThreadPool 的定义）
+struct Executor {
+    void* context = nullptr;
+    void (*submit)(void* context, UniqueFunction<void()>&& task) = nullptr;
+
+    explicit operator bool() const { return submit != nullptr; }
+
+    // 没有执行器时在当前线程直接运行
+    void operator()(UniqueFunction<void()>&& task) const {
+        if (submit) {
+            submit(context, std::move(task));
+        } else {
+            task();
+        }
+    }
+};
+
+template<typename T> class Future;
+template<typename T> class Promise;
+template<typename T> struct FutureAwaiter;
+
+namespace detail {
+
+struct Unit {};     // void 结果的占位类型
+
+template<typename T>
+using Stored = std::conditional_t<std::is_void<T>::value, Unit, T>;
+
+template<typename T>
+struct IsFuture : std::false_type {};
+template<typename T>
+struct IsFuture<Future<T>> : std::true_type {};
+
+// 共享状态：结果或异常 + 至多一个完成回调（Future 只能被消费一次）
+template<typename T>
+class FutureState {
+public:
+    explicit FutureState(Executor executor) : executor_(executor) {}
+
+    bool ready() const { return ready_.load(std::memory_order_acquire); }
+
+    void setValue(Stored<T>&& value) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (ready_.load(std::memory_order_relaxed)) throw std::future_error(std::future_errc::promise_already_satisfied);
+        value_.emplace(std::move(value));
+        complete(lock);
+    }
+
+    void setException(std::exception_ptr error) {
+        if (!trySetException(error)) throw std::future_error(std::future_errc::promise_already_satisfied);
+    }
+
+    // 尚未就绪时以 error 完成并返回 true；已经就绪时什么也不做
+    bool trySetException(std::exception_ptr error) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (ready_.load(std::memory_order_relaxed)) return false;
+        error_ = error;
+        complete(lock);
+        return true;
+    }
+
+    // 就绪时在完成的线程上调用 callback（已经就绪则立即在当前线程调用）；callback 应当很轻
+    void subscribe(UniqueFunction<void()> callback) {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (!ready_.load(std::memory_order_relaxed)) {
+                callback_ = std::move(callback);
+                return;
+            }
+        }
+        callback();
+    }
+
+    void wait() {
+        if (ready()) return;
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [this] { return ready_.load(std::memory_order_relaxed); });
+    }
+
+    // 以下只在就绪之后调用
+    bool failed() const { return error_ != nullptr; }
+    std::exception_ptr error() const { return error_; }
+    Stored<T> takeValue() {
+        if (error_) std::rethrow_exception(error_);
+        return std::move(*value_);
+    }
+
+    Executor executor() const { return executor_; }
+
+private:
+    void complete(std::unique_lock<std::mutex>& lock) {
+        ready_.store(true, std::memory_order_release);
+        UniqueFunction<void()> callback = std::move(callback_);
+        lock.unlock();
+        cv_.notify_all();
+        if (callback) callback();
+    }
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::atomic<bool> ready_{false};
+    std::optional<Stored<T>> value_;
+    std::exception_ptr error_;
+    UniqueFunction<void()> callback_;
+    Executor executor_;         // then() 默认使用的执行器
+};
+
+template<typename T>
+std::shared_ptr<FutureState<T>> makeState(Executor executor) {
+    return std::allocate_shared<FutureState<T>>(RecyclingAllocator<FutureState<T>>(), executor);
+}
+
+} // namespace detail
+
+template<typename T>
+class Promise {
+public:
+    explicit Promise(Executor executor = Executor())
+        : state_(detail::makeState<T>(executor)), retrieved_(false) {}
+
+    Promise(Promise&&) noexcept = default;
+    Promise& operator=(Promise&& other) noexcept {
+        if (this != &other) {
+            abandon();
+            state_ = std::move(other.state_);
+            retrieved_ = other.retrieved_;
+        }
+        return *this;
+    }
+
+    // 未设置结果就销毁：等待方得到 broken_promise
+    ~Promise() { abandon(); }
+
+    Future<T> get_future() {
+        if (!state_) throw std::future_error(std::future_errc::no_state);
+        if (retrieved_) throw std::future_error(std::future_errc::future_already_retrieved);
+        retrieved_ = true;
+        return Future<T>(state_);
+    }
+
+    // 完成回调在当前线程上运行，它抛出的异常会传给调用方；此时 Promise 已经被满足
+    template<typename U = T, typename = std::enable_if_t<!std::is_void<U>::value>>
+    void set_value(U&& value) {
+        checkState();
+        auto state = std::move(state_);
+        state->setValue(detail::Stored<T>(std::forward<U>(value)));
+    }
+
+    template<typename U = T, typename = std::enable_if_t<std::is_void<U>::value>>
+    void set_value() {
+        checkState();
+        auto state = std::move(state_);
+        state->setValue(detail::Unit{});
+    }
+
+    void set_exception(std::exception_ptr error) {
+        checkState();
+        auto state = std::move(state_);
+        state->setException(error);
+    }
+
+    // 运行 f(args...) 并用其结果（或异常）完成这个 Promise；只转换 f 抛出的异常，完成回调的异常照常传出
+    template<typename F, typename... Args>
+    void set_from(F&& f, Args&&... args) {
+        std::optional<detail::Stored<T>> result;
+        try {
+            if constexpr (std::is_void<T>::value) {
+                std::invoke(std::forward<F>(f), std::forward<Args>(args)...);
+                result.emplace();
+            } else {
+                result.emplace(std::invoke(std::forward<F>(f), std::forward<Args>(args)...));
+            }
+        } catch (...) {
+            set_exception(std::current_exception());
+            return;
+        }
+        if constexpr (std::is_void<T>::value) {
+            set_value();
+        } else {
+            set_value(std::move(*result));
+        }
+    }
+
+private:
+    template<typename U> friend class Future;
+
+    void checkState() const {
+        if (!state_) throw std::future_error(std::future_errc::promise_already_satisfied);
+    }
+
+    void abandon() {
+        if (state_ && !state_->ready()) {
+            state_->setException(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        }
+        state_.reset();
+    }
+
+    std::shared_ptr<detail::FutureState<T>> state_;
+    bool retrieved_;
+};
+
+template<typename T>
+class Future {
+public:
+    using value_type = T;
+
+    Future() = default;
+    Future(Future&&) noexcept = default;
+    Future& operator=(Future&&) noexcept = default;
+
+    bool valid() const { return state_ != nullptr; }
+    bool ready() const { return state_ && state_->ready(); }
+
+    void wait() const {
+        checkValid();
+        state_->wait();
+    }
+
+    // 阻塞直到就绪并取出结果（或重新抛出异常）；之后 Future 不再有效
+    T get() {
+        checkValid();
+        state_->wait();
+        auto state = std::move(state_);
+        if constexpr (std::is_void<T>::value) {
+            state->takeValue();
+        } else {
+            return state->takeValue();
+        }
+    }
+
+    // 就绪后在执行器上运行 f(value)（void 时为 f()），返回 f 结果的 Future；f 返回 Future<U> 时结果为 Future<U>
+    template<typename F>
+    auto then(F&& f) {
+        checkValid();
+        Executor executor = state_->executor();
+        return then(executor, std::forward<F>(f));
+    }
+
+    template<typename F>
+    auto then(Executor executor, F&& f) {
+        using R = typename ContinuationResult<F>::type;
+        using Result = typename UnwrapFuture<R>::type;
+        checkValid();
+        Promise<Result> promise(executor);
+        Future<Result> result = promise.get_future();
+        auto state = std::move(state_);
+        auto* raw = state.get();
+        raw->subscribe([state = std::move(state), executor, fn = std::forward<F>(f),
+                        promise = std::move(promise)]() mutable {
+            if (state->failed()) {
+                promise.set_exception(state->error());   // 跳过 f，异常继续向下游传递
+                return;
+            }
+            auto invoke = [state = std::move(state), fn = std::move(fn)]() mutable -> R {
+                if constexpr (std::is_void<T>::value) {
+                    return std::invoke(std::move(fn));
+                } else {
+                    return std::invoke(std::move(fn), state->takeValue());
+                }
+            };
+            if (!executor) {
+                runContinuation<R>(promise, invoke);
+                return;
+            }
+            // 执行器拒绝任务时可能已经把它销毁（如 ThreadPool::post 先构造任务再检查是否已停止），
+            // 任务若独占 promise，下游会先以 broken_promise 完成。因此提交期间这里也持有一份 promise，
+            // 提交失败时下游以真实的异常完成；提交成功后只剩任务持有，任务未执行就被丢弃时仍是 broken_promise
+            auto downstream = promise.state_;
+            auto shared = std::make_shared<Promise<Result>>(std::move(promise));
+            UniqueFunction<void()> task([invoke = std::move(invoke), shared]() mutable {
+                runContinuation<R>(*shared, invoke);
+            });
+            try {
+                executor.submit(executor.context, std::move(task));
+            } catch (...) {
+                downstream->trySetException(std::current_exception());   // 提交失败（如线程池已停止）：下游以该异常完成
+            }
+        });
+        return result;
+    }
+
+    // 上游失败时以 f(exception_ptr) 的结果代替（在完成的线程上直接运行，f 应当很轻）
+    template<typename F>
+    Future<T> recover(F&& f) {
+        checkValid();
+        Promise<T> promise(state_->executor());
+        Future<T> result = promise.get_future();
+        auto state = std::move(state_);
+        auto* raw = state.get();
+        raw->subscribe([state = std::move(state), fn = std::forward<F>(f), promise = std::move(promise)]() mutable {
+            if (!state->failed()) {
+                if constexpr (std::is_void<T>::value) {
+                    promise.set_value();
+                } else {
+                    promise.set_value(state->takeValue());
+                }
+                return;
+            }
+            promise.set_from(std::move(fn), state->error());
+        });
+        return result;
+    }
+
+private:
+    template<typename U> friend class Promise;
+    template<typename U> friend class Future;
+    template<typename U> friend struct FutureAwaiter;     // 协程适配（Coroutine.h）
+    template<typename U> friend Future<std::vector<U>> when_all(std::vector<Future<U>> futures);
+    friend Future<void> when_all(std::vector<Future<void>> futures);
+    template<typename U> friend auto when_any(std::vector<Future<U>> futures);
+
+    explicit Future(std::shared_ptr<detail::FutureState<T>> state) : state_(std::move(state)) {}
+
+    void checkValid() const {
+        if (!state_) throw std::future_error(std::future_errc::no_state);
+    }
+
+    template<typename F, bool IsVoid = std::is_void<T>::value>
+    struct ContinuationResult {
+        using type = std::invoke_result_t<std::decay_t<F>, T>;
+    };
+    template<typename F>
+    struct ContinuationResult<F, true> {
+        using type = std::invoke_result_t<std::decay_t<F>>;
+    };
+
+    template<typename R>
+    struct UnwrapFuture { using type = R; };
+    template<typename U>
+    struct UnwrapFuture<Future<U>> { using type = U; };
+
+    // 运行 continuation 并完成 promise；返回 Future 时等它完成后再转交结果
+    template<typename R, typename P, typename Body>
+    static void runContinuation(P& promise, Body&& body) {
+        if constexpr (detail::IsFuture<R>::value) {
+            using U = typename R::value_type;
+            R inner;
+            try {
+                inner = body();
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+                return;
+            }
+            auto innerState = std::move(inner.state_);
+            auto* raw = innerState.get();
+            raw->subscribe([innerState = std::move(innerState), promise = std::move(promise)]() mutable {
+                if (innerState->failed()) {
+                    promise.set_exception(innerState->error());
+                } else if constexpr (std::is_void<U>::value) {
+                    promise.set_value();
+                } else {
+                    promise.set_value(innerState->takeValue());
+                }
+            });
+        } else {
+            promise.set_from(std::forward<Body>(body));
+        }
+    }
+
+    std::shared_ptr<detail::FutureState<T>> state_;
+};
+
+template<typename T>
+Future<std::decay_t<T>> make_ready_future(T&& value) {
+    Promise<std::decay_t<T>> promise;
+    Future<std::decay_t<T>> result = promise.get_future();
+    promise.set_value(std::forward<T>(value));
+    return result;
+}
+
+inline Future<void> make_ready_future() {
+    Promise<void> promise;
+    Future<void> result = promise.get_future();
+    promise.set_value();
+    return result;
+}
+
+template<typename T>
+Future<T> make_exceptional_future(std::exception_ptr error) {
+    Promise<T> promise;
+    Future<T> result = promise.get_future();
+    promise.set_exception(error);
+    return result;
+}
+
+namespace detail {
+
+// when_all 的汇总状态：剩余个数 + 各输入的结果；第一个异常立即让结果失败
+template<typename T>
+struct AllState {
+    AllState(size_t n, Executor executor) : remaining(n), promise(executor), results(n) {}
+
+    std::atomic<size_t> remaining;
+    std::atomic<bool> failed{false};
+    Promise<std::conditional_t<std::is_void<T>::value, void, std::vector<T>>> promise;
+    std::vector<std::optional<Stored<T>>> results;
+};
+
+} // namespace detail
+
+// 全部完成时就绪，结果按输入顺序排列；任一输入失败时立即以该异常失败
+template<typename T>
+Future<std::vector<T>> when_all(std::vector<Future<T>> futures) {
+    if (futures.empty()) return make_ready_future(std::vector<T>());
+    Executor executor = futures.front().state_->executor();
+    auto all = std::make_shared<detail::AllState<T>>(futures.size(), executor);
+    Future<std::vector<T>> result = all->promise.get_future();
+    for (size_t i = 0; i < futures.size(); ++i) {
+        futures[i].checkValid();
+        auto state = std::move(futures[i].state_);
+        auto* raw = state.get();
+        raw->subscribe([all, i, state = std::move(state)] {
+            if (state->failed()) {
+                if (!all->failed.exchange(true)) all->promise.set_exception(state->error());
+                return;
+            }
+            all->results[i].emplace(state->takeValue());
+            if (all->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 && !all->failed.load()) {
+                std::vector<T> values;
+                values.reserve(all->results.size());
+                for (auto& value : all->results) values.push_back(std::move(*value));
+                all->promise.set_value(std::move(values));
+            }
+        });
+    }
+    return result;
+}
+
+inline Future<void> when_all(std::vector<Future<void>> futures) {
+    if (futures.empty()) return make_ready_future();
+    Executor executor = futures.front().state_->executor();
+    auto all = std::make_shared<detail::AllState<void>>(futures.size(), executor);
+    Future<void> result = all->promise.get_future();
+    for (auto& future : futures) {
+        future.checkValid();
+        auto state = std::move(future.state_);
+        auto* raw = state.get();
+        raw->subscribe([all, state = std::move(state)] {
+            if (state->failed()) {
+                if (!all->failed.exchange(true)) all->promise.set_exception(state->error());
+                return;
+            }
+            if (all->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 && !all->failed.load()) {
+                all->promise.set_value();
+            }
+        });
+    }
+    return result;
+}
+
+// when_any 的结果：最先完成的输入下标及其值（void 输入只有下标）
+template<typename T>
+struct WhenAnyResult {
+    size_t index;
+    T value;
+};
+
+template<>
+struct WhenAnyResult<void> {
+    size_t index;
+};
+
+// 任一输入完成（成功或失败）时就绪；其余输入的结果被丢弃
+template<typename T>
+auto when_any(std::vector<Future<T>> futures) {
+    using Result = WhenAnyResult<T>;
+    if (futures.empty()) throw std::invalid_argument("when_any needs at least one future");
+    struct AnyState {
+        explicit AnyState(Executor executor) : promise(executor) {}
+        std::atomic<bool> done{false};
+        Promise<Result> promise;
+    };
+    auto any = std::make_shared<AnyState>(futures.front().state_->executor());
+    Future<Result> result = any->promise.get_future();
+    for (size_t i = 0; i < futures.size(); ++i) {
+        futures[i].checkValid();
+        auto state = std::move(futures[i].state_);
+        auto* raw = state.get();
+        raw->subscribe([any, i, state = std::move(state)] {
+            if (any->done.exchange(true)) return;
+            if (state->failed()) {
+                any->promise.set_exception(state->error());
+            } else if constexpr (std::is_void<T>::value) {
+                any->promise.set_value(Result{i});
+            } else {
+                any->promise.set_value(Result{i, state->takeValue()});
+            }
+        });
+    }
+    return result;
+}
+
+#endif // FUTURE_H
@@ -0,0 +1,132 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+/*
+ **************** 对数-线性直方图 ****************
+ 设计目标：
+    1. 记录纳秒级延迟：按 2 的幂分组，每组再线性分为 8 个子桶，相对误差不超过 12.5%
+    2. 单写者记录（每个工作线程一份）：计数器用 relaxed load + store 递增，没有原子读改写和缓存行争用
+    3. 其他线程随时可以读取快照并合并，计算 p50 / p99 / p999 等分位数
+    4. SingleWriterCounter：同样是单写者计数器，供每个工作线程各自累加，读取方随时读取
+*/
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// 直方图快照：普通整数数组，可合并、可计算分位数
+class HistogramSnapshot {
+public:
+    static constexpr size_t kSubBits = 3;
+    static constexpr size_t kSubBuckets = size_t(1) << kSubBits;   // 每组 8 个子桶
+    static constexpr size_t kMaxExponent = 40;                      // 最大约 2^41 ns（约 36 分钟），更大的值截断
+    static constexpr size_t kBuckets = (kMaxExponent - kSubBits + 2) * kSubBuckets;
+
+    HistogramSnapshot() { counts_.fill(0); }
+
+    static size_t bucketOf(uint64_t value) {
+        const uint64_t maxValue = (uint64_t(1) << (kMaxExponent + 1)) - 1;
+        if (value > maxValue) value = maxValue;
+        if (value < kSubBuckets) return static_cast<size_t>(value);
+        size_t exponent = 63 - static_cast<size_t>(__builtin_clzll(value));
+        size_t sub = static_cast<size_t>(value >> (exponent - kSubBits)) & (kSubBuckets - 1);
+        return (exponent - kSubBits + 1) * kSubBuckets + sub;
+    }
+
+    // 桶的上界（该桶中最大可能的值）
+    static uint64_t bucketUpperBound(size_t bucket) {
+        if (bucket < kSubBuckets) return bucket;
+        size_t exponent = bucket / kSubBuckets + kSubBits - 1;
+        size_t sub = bucket % kSubBuckets;
+        uint64_t width = uint64_t(1) << (exponent - kSubBits);
+        return ((kSubBuckets + sub) << (exponent - kSubBits)) + width - 1;
+    }
+
+    uint64_t& operator[](size_t bucket) { return counts_[bucket]; }
+    uint64_t operator[](size_t bucket) const { return counts_[bucket]; }
+
+    void merge(const HistogramSnapshot& other) {
+        for (size_t i = 0; i < kBuckets; ++i) counts_[i] += other.counts_[i];
+    }
+
+    uint64_t count() const {
+        uint64_t total = 0;
+        for (uint64_t c : counts_) total += c;
+        return total;
+    }
+
+    // 分位数（q 取 0~1），返回所在桶的上界；没有样本时返回 0
+    uint64_t percentile(double q) const {
+        uint64_t total = count();
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            seen += counts_[i];
+            if (seen >= rank) return bucketUpperBound(i);
+        }
+        return bucketUpperBound(kBuckets - 1);
+    }
+
+    uint64_t max() const {
+        for (size_t i = kBuckets; i-- > 0;) {
+            if (counts_[i]) return bucketUpperBound(i);
+        }
+        return 0;
+    }
+
+private:
+    std::array<uint64_t, kBuckets> counts_;
+};
+
+// 可并发读取的直方图：record() 只允许一个线程调用，recordShared() 允许多个线程同时调用
+class LatencyHistogram {
+public:
+    LatencyHistogram() {
+        for (auto& c : counts_) c.store(0, std::memory_order_relaxed);
+    }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t value) {
+        auto& c = counts_[HistogramSnapshot::bucketOf(value)];
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void recordShared(uint64_t value) {
+        counts_[HistogramSnapshot::bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 把当前计数累加到 out 中
+    void snapshotInto(HistogramSnapshot& out) const {
+        for (size_t i = 0; i < HistogramSnapshot::kBuckets; ++i) {
+            out[i] += counts_[i].load(std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, HistogramSnapshot::kBuckets> counts_;
+};
+
+// 单写者计数器：只有一个线程调用 add()，其他线程可随时 load()；没有原子读改写
+class SingleWriterCounter {
+public:
+    SingleWriterCounter() : value_(0) {}
+
+    SingleWriterCounter(const SingleWriterCounter&) = delete;
+    SingleWriterCounter& operator=(const SingleWriterCounter&) = delete;
+
+    void add(uint64_t n = 1) {
+        value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    uint64_t load() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_;
+};
+
+#endif // HISTOGRAM_H
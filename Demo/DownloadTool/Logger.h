@@ -1,24 +1,56 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+/*
+ **************** 异步日志（Logger） ****************
+ 设计目标：
+    1. 单例；log() 只把消息交给后台写入线程，格式化、写文件、按大小轮转都在写入线程上完成
+    2. 前端不分配内存、不取共享锁：每个写日志的线程一个 SPSC 环形缓冲区，存放定长记录
+       （时间戳、级别、正文）；log() 只读一次时钟、做一次 memcpy 并发布 tail；
+       只有线程第一次写日志时分配并登记自己的环（持有 mtx_）
+    3. 超过一条记录的消息占用连续多条记录并一次发布，写入线程总是看到完整消息；同一线程的日志保持顺序，
+       不同线程之间按写入线程轮转取批的顺序落盘，不保证严格按时间排序
+    4. 某个环积压达到 bufferSize 条时唤醒写入线程，否则写入线程最多每 kFlushInterval 醒来一次；
+       环满时生产者让出 CPU 等待写入线程腾出空间，不丢日志
+    5. 线程退出时它的环被标记为关闭，写入线程排空后释放
+    6. 文件写入走 AsyncIO（io_uring）：一批日志拷贝进注册缓冲区后一次提交；io_uring 不可用时
+       pwrite 由 AsyncIO 自己的写线程执行，写入线程同样不等待磁盘
+    7. 延迟格式化：LOG_FMT(level, "printf 格式串", 参数...) 只记录格式串 ID 和参数的二进制编码（见 BinaryLog.h），
+       调用方不做任何格式化；写入线程按 Output 设置输出文本，或直接写紧凑的二进制文件（.nlog），
+       由 log_decoder 离线还原为文本
+    8. 时间戳精确到微秒，由写入线程的 TimestampCache 格式化：日期和时分秒每秒只计算一次
+    9. 轮转不扫描目录：启动时扫描一次，建立按新旧排序的文件索引（含大小），之后新建、删除文件都只更新索引；
+       按文件数（maxFiles）和总字节数（maxTotalBytes，0 表示不限制）两种上限删除最旧的文件
+   10. 一轮排空写满的多个缓冲区合并为一次向量写（writev）；新文件用 fallocate 预分配到 maxFileSize，
+       关闭时释放没用到的部分；可选每写出 N 字节用 sync_file_range 发起后台回写，避免脏页集中刷盘
+*/
+
 #include <mutex>
 #include <condition_variable>
 #include <thread>
 #include <fstream>
-#include <sstream>
 #include <chrono>
 #include <filesystem>
-#include <queue>
-#include <future>
 #include <string>
+#include <string_view>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
 #include <vector>
+#include <deque>
 #include <algorithm>
 #include <memory>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include "AsyncIO.h"
+#include "BinaryLog.h"
 
 class Logger
 {
 public:
-    enum class Level
+    enum class Level : uint8_t
     {
         DEFAULT,
         DEBUG,
@@ -27,15 +59,23 @@ public:
         ERROR
     };
 
+    // 日志文件格式：文本，或二进制（延迟格式化，需用 log_decoder 解码）
+    enum class Output
+    {
+        Text,
+        Binary
+    };
+
     // 获取单例实例
     static Logger &getInstance(const std::string &logDir = "logs", Level minLevel = Level::INFO,
-                                size_t maxFileSize = 250 * 1024, size_t maxFiles = 100, size_t bufferSize = 100)
+                                size_t maxFileSize = 250 * 1024, size_t maxFiles = 100, size_t bufferSize = 100,
+                                uint64_t maxTotalBytes = 0)
     {
         static std::once_flag onceFlag;
         static std::unique_ptr<Logger> instance;
 
         std::call_once(onceFlag, [&]() {
-            instance.reset(new Logger(logDir, minLevel, maxFileSize, maxFiles, bufferSize));
+            instance.reset(new Logger(logDir, minLevel, maxFileSize, maxFiles, bufferSize, maxTotalBytes));
         });
 
         return *instance;
@@ -46,22 +86,46 @@ public:
     Logger(Logger &&) = delete; // 禁止移动构造函数
     Logger &operator=(Logger &&) = delete; // 禁止移动赋值操作符
 
-    // 日志函数：记录日志消息
-    void log(Level level, const std::string &message)
+    // 日志函数：记录日志消息（写入本线程的环，不分配内存、不加锁）
+    void log(Level level, std::string_view message)
     {
         if (level < minLevel_)
             return;
+        publish(level, 0, message);
+    }
 
-        std::string logEntry = formatLogEntry(level, message);
-    
-        // 生产者-消费者模式：生产者生产日志
+    // 延迟格式化日志：只记录格式串 ID 和参数编码，一般通过 LOG_FMT 宏调用
+    template<typename... Args>
+    void logFormat(Level level, uint16_t formatId, const Args &...args)
+    {
+        if (level < minLevel_)
+            return;
+        if (formatId == 0)
         {
-            std::lock_guard<std::mutex> lock(mtx_);
-            buffer_.push(logEntry);  // 使用队列代替vector
-            if (buffer_.size() >= bufferSize_) {
-                cv_.notify_one();
-            }
+            publish(level, 0, "<LOG_FMT format table full>");
+            return;
+        }
+        thread_local std::string encoded; // 重复使用，预热后不再分配
+        encoded.clear();
+        (binlog::encodeArg(encoded, args), ...);
+        if (encoded.size() > kMaxParts * kRecordText)
+        {
+            publish(level, 0, "<LOG_FMT arguments too long>"); // 截断会破坏编码，整条丢弃
+            return;
         }
+        publish(level, formatId, encoded);
+    }
+
+    // 每写出 bytes 字节发起一次后台回写（sync_file_range，不等待完成）；0 表示交给内核自行回写
+    void setWriteBack(size_t bytes)
+    {
+        writeBackBytes_.store(bytes, std::memory_order_relaxed);
+    }
+
+    // 设置日志文件格式：与当前文件不同时，写入线程在下一轮开始前新建一个该格式的文件
+    void setOutput(Output output)
+    {
+        output_.store(output, std::memory_order_relaxed);
     }
 
     // 析构函数：停止写入线程，写入剩余日志
@@ -74,19 +138,71 @@ public:
         cv_.notify_all();
         if (writerThread_.joinable())
         {
-            writerThread_.join();
+            writerThread_.join(); // 写入线程退出前会排空所有环
+        }
+        io_.drain();   // 等待所有异步写完成
+        if (logFd_ >= 0)
+        {
+            closeFile();
         }
-        flushBuffer(); // 写入剩余日志
+    }
+
+    // 日志文件 I/O 的统计（系统调用次数、写入字节数等）
+    AsyncIO::Stats ioStats() const
+    {
+        return io_.stats();
     }
 
 private:
+    // 把一条消息（正文或参数编码）写入本线程的环并发布
+    void publish(Level level, uint16_t formatId, std::string_view message)
+    {
+        int64_t timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::system_clock::now().time_since_epoch()).count();
+        size_t parts = std::max<size_t>(1, (message.size() + kRecordText - 1) / kRecordText);
+        if (parts > kMaxParts)
+        {
+            parts = kMaxParts; // 超长消息截断
+            message = message.substr(0, kMaxParts * kRecordText);
+        }
+
+        LogRing &ring = localRing();
+        uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        waitForSpace(ring, tail + parts);
+        for (size_t i = 0; i < parts; ++i)
+        {
+            Record &record = ring.records[(tail + i) & (kRingCapacity - 1)];
+            size_t offset = i * kRecordText;
+            record.length = static_cast<uint16_t>(std::min(kRecordText, message.size() - offset));
+            std::memcpy(record.text, message.data() + offset, record.length);
+        }
+        Record &first = ring.records[tail & (kRingCapacity - 1)];
+        first.timeNs = timeNs;
+        first.level = level;
+        first.formatId = formatId;
+        first.parts = static_cast<uint16_t>(parts);
+        ring.tail.store(tail + parts, std::memory_order_release);
+
+        // 写入线程在休眠且积压达到 bufferSize 条时唤醒它。积压按最新的 head 计算：
+        // cachedHead 只在环将满时刷新，用它会把早已消费的记录也算作积压，导致过早唤醒
+        if (writerSleeping_.load(std::memory_order_relaxed))
+        {
+            ring.cachedHead = ring.head.load(std::memory_order_acquire);
+            if (tail + parts - ring.cachedHead >= bufferSize_)
+                wakeWriter();
+        }
+    }
+
     // 私有构造函数（单例模式）：初始化目录、级别、参数
     Logger(const std::string &logDir = "logs", Level minLevel = Level::INFO,
-           size_t maxFileSize = 250 * 1024, size_t maxFiles = 100, size_t bufferSize = 100)
+           size_t maxFileSize = 250 * 1024, size_t maxFiles = 100, size_t bufferSize = 100,
+           uint64_t maxTotalBytes = 0)
         : logDir_(logDir), minLevel_(minLevel), maxFileSize_(maxFileSize), maxFiles_(maxFiles),
-          bufferSize_(bufferSize), stop_(false), currentFileSize_(0)
+          maxTotalBytes_(maxTotalBytes), bufferSize_(bufferSize), currentFileSize_(0), io_(Executor{}, ioOptions()),
+          stop_(false)
     {
         std::filesystem::create_directory(logDir_);
+        loadSegments();
         writerThread_ = std::thread(&Logger::writerLoop, this);
     }
 
@@ -94,121 +210,465 @@ private:
     Level minLevel_;                  // 最低日志等级
     size_t maxFileSize_;              // 单文件最大大小（字节）
     size_t maxFiles_;                 // 最大文件数
-    size_t bufferSize_;               // 缓冲区大小
-    std::queue<std::string> buffer_;  // 改用队列实现生产者-消费者模式
-    std::ofstream logFile_;           // 当前日志文件
+    uint64_t maxTotalBytes_;          // 所有日志文件的总大小上限（0 表示不限制）
+    size_t bufferSize_;               // 单个环积压多少条记录时唤醒写入线程
+    int logFd_ = -1;                  // 当前日志文件
+    off_t fileOffset_ = 0;            // 下一次写入的文件偏移（异步写使用显式偏移）
     size_t currentFileSize_;          // 当前文件大小
     std::string currentFileName_;     // 当前文件名
 
+    // 日志文件索引（只由写入线程访问；构造时由构造线程建立）
+    struct Segment
+    {
+        std::string path;
+        uint64_t size;                // 文件关闭时更新；当前文件为 0
+    };
+    std::deque<Segment> segments_;    // 按文件名（即创建时间）从旧到新，打开的文件在最后
+    uint64_t closedBytes_ = 0;        // 已关闭文件的总大小
+    size_t nextSequence_ = 0;         // 文件名中的序号，单调递增，同一秒内多次轮转也不会重名
+
+    // 异步写：一批日志拷贝进 AsyncIO 的注册缓冲区，写满或本批结束时提交，写入线程不等待磁盘
+    static constexpr size_t kIOBufferSize = 64 * 1024;
+    AsyncIO io_;
+    AsyncIO::Buffer chunk_;           // 正在填充的缓冲区
+    size_t chunkUsed_ = 0;
+    static constexpr size_t kMaxBatchChunks = 16;                   // 一次向量写最多合并的缓冲区数
+    std::vector<std::pair<AsyncIO::Buffer, size_t>> batch_;        // 已写满、等待合并写出的缓冲区
+    off_t batchOffset_ = 0;           // batch_ 第一个缓冲区对应的文件偏移
+    bool preallocated_ = false;       // 当前文件是否已预分配到 maxFileSize_
+    std::atomic<size_t> writeBackBytes_{0};
+    off_t writeBackStart_ = 0;        // 尚未发起回写的起点
+    off_t writeBackEnd_ = 0;          // 上一轮写出的数据的末尾
+
+    // 前端：每个线程的定长记录环
+    static constexpr size_t kRecordSize = 256;
+    static constexpr size_t kRecordText = kRecordSize - 16;            // 每条记录的正文容量
+    static constexpr size_t kRingCapacity = 1024;                      // 每个环的记录数（2 的幂）
+    static constexpr size_t kMaxParts = kRingCapacity / 4;             // 一条消息最多占用的记录数
+    static constexpr size_t kDrainBatch = 64;                          // 写入线程每轮从一个环取的记录数上限
+    static constexpr std::chrono::milliseconds kFlushInterval{50};     // 写入线程最长休眠时间
+
+    // 定长记录：消息的第一条记录带时间戳、级别和记录数，后续记录只有正文
+    struct Record
+    {
+        int64_t timeNs;               // system_clock 时间戳（纳秒）
+        uint16_t parts;               // 本消息占用的记录数（只在第一条记录中有效）
+        uint16_t length;              // 本记录的正文字节数
+        uint16_t formatId;            // 0：正文是文本；否则正文是 LOG_FMT 的参数编码
+        Level level;
+        char text[kRecordText];
+    };
+    static_assert(sizeof(Record) == kRecordSize, "Record must stay fixed-size");
+
+    // 单生产者单消费者环：生产者是登记它的线程，消费者是写入线程
+    struct LogRing
+    {
+        alignas(64) std::atomic<uint64_t> head{0}; // 写入线程已消费到的位置
+        alignas(64) std::atomic<uint64_t> tail{0}; // 生产者已发布到的位置
+        uint64_t cachedHead = 0;                   // 生产者缓存的 head，减少读取写入线程的缓存行
+        std::atomic<bool> closed{false};           // 生产者线程已退出
+        Record records[kRingCapacity];
+    };
+
+    // 线程退出时标记它的环为关闭，由写入线程排空后释放
+    struct RingHandle
+    {
+        std::shared_ptr<LogRing> ring;
+        ~RingHandle()
+        {
+            if (ring)
+                ring->closed.store(true, std::memory_order_release);
+        }
+    };
+
+    std::vector<std::shared_ptr<LogRing>> rings_; // 已登记的环（受 mtx_ 保护）
+    bool ringsChanged_ = false;                   // rings_ 自写入线程上次复制后是否变化
+    std::atomic<bool> writerSleeping_{false};     // 写入线程是否在等待，生产者据此决定是否唤醒
+    std::string entry_;                           // 写入线程格式化用的缓冲，重复使用
+    std::string payload_;                         // 跨多条记录的参数编码拼接缓冲
+
+    // 输出格式：output_ 由 setOutput 设置，binaryFile_ 是当前文件的实际格式（只由写入线程访问）
+    std::atomic<Output> output_{Output::Text};
+    bool binaryFile_ = false;
+    int64_t lastTimeNs_ = 0;                      // 二进制文件中上一条日志的时间戳
+    std::vector<bool> formatWritten_;             // 二进制文件中已写过字典条目的格式串 ID
+
     std::thread writerThread_;        // 写入线程
     std::mutex mtx_;
     std::condition_variable cv_;
     bool stop_;
 
-    // 辅助函数：格式化日志条目
-    std::string formatLogEntry(Level level, const std::string &message)
+    // 本线程的环：第一次写日志时创建并登记
+    LogRing &localRing()
     {
-        static const std::string levelStr[] = {"DEFAULT", "DEBUG", "INFO", "WARNING", "ERROR"};
-        auto now = std::chrono::system_clock::now();
-        auto time = std::chrono::system_clock::to_time_t(now);
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S")
-           << " [" << levelStr[static_cast<int>(level)] << "] " << message;
-        return ss.str();
+        thread_local RingHandle handle;
+        if (!handle.ring)
+        {
+            handle.ring = std::make_shared<LogRing>();
+            std::lock_guard<std::mutex> lock(mtx_);
+            rings_.push_back(handle.ring);
+            ringsChanged_ = true;
+        }
+        return *handle.ring;
+    }
+    // 等待环中有空间容纳到 end 为止的记录
+    void waitForSpace(LogRing &ring, uint64_t end)
+    {
+        while (end - ring.cachedHead > kRingCapacity)
+        {
+            ring.cachedHead = ring.head.load(std::memory_order_acquire);
+            if (end - ring.cachedHead <= kRingCapacity)
+                break;
+            wakeWriter();
+            std::this_thread::yield();
+        }
+    }
+    void wakeWriter()
+    {
+        if (writerSleeping_.exchange(false, std::memory_order_relaxed))
+        {
+            cv_.notify_one(); // 不持锁通知：偶尔丢失的唤醒由 kFlushInterval 兜底
+        }
     }
     // 辅助函数：生成新日志文件名
-    std::string generateFileName()
+    std::string generateFileName(const char *extension)
     {
-        auto now = std::chrono::system_clock::now();
-        auto time = std::chrono::system_clock::to_time_t(now);
-        std::stringstream ss;
-        ss << logDir_ << "/log_" << std::put_time(std::localtime(&time), "%Y%m%d_%H%M%S")
-           << "_" << std::setw(3) << std::setfill('0') << getFileCount() << ".log";
-        return ss.str();
+        std::time_t time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        std::tm tm{};
+        localtime_r(&time, &tm); // 写入线程之外也有线程在格式化时间，不能用共享缓冲区的 localtime
+        char buf[64];
+        size_t n = std::strftime(buf, sizeof(buf), "/log_%Y%m%d_%H%M%S_", &tm);
+        std::snprintf(buf + n, sizeof(buf) - n, "%03zu%s", nextSequence_++, extension);
+        return logDir_ + buf;
     }
-    // 辅助函数：获取当前日志文件数
-    size_t getFileCount()
+    // 辅助函数：文本（.log）和二进制（.nlog）日志都参与计数和轮转
+    static bool isLogFile(const std::filesystem::path &path)
+    {
+        return path.extension() == ".log" || path.extension() == ".nlog";
+    }
+    // 辅助函数：启动时扫描一次日志目录，建立文件索引
+    void loadSegments()
     {
-        std::vector<std::string> files;
         for (const auto &entry : std::filesystem::directory_iterator(logDir_))
         {
-            if (entry.is_regular_file() && entry.path().extension() == ".log")
+            if (entry.is_regular_file() && isLogFile(entry.path()))
+            {
+                segments_.push_back({entry.path().string(), entry.file_size()});
+            }
+        }
+        std::sort(segments_.begin(), segments_.end(),
+                  [](const Segment &a, const Segment &b) { return a.path < b.path; });
+        for (const Segment &segment : segments_)
+        {
+            closedBytes_ += segment.size;
+        }
+        nextSequence_ = segments_.size();
+    }
+    // 辅助函数：为即将新建的文件腾出空间（按 maxFileSize 预留），从最旧的文件开始删除
+    void pruneSegments()
+    {
+        while (!segments_.empty() &&
+               (segments_.size() >= maxFiles_ || (maxTotalBytes_ > 0 && closedBytes_ + maxFileSize_ > maxTotalBytes_)))
+        {
+            std::error_code ec;
+            std::filesystem::remove(segments_.front().path, ec); // 已被外部删除时忽略
+            closedBytes_ -= segments_.front().size;
+            segments_.pop_front();
+        }
+    }
+    static AsyncIO::Options ioOptions()
+    {
+        AsyncIO::Options options;
+        options.queueDepth = 64;
+        options.registeredBuffers = kMaxBatchChunks;
+        options.bufferSize = kIOBufferSize;
+        options.fallbackThread = true;    // 没有 io_uring 时 pwrite 交给 AsyncIO 的写线程，不占用写入线程
+        return options;
+    }
+    // 辅助函数：轮流排空所有环，写入文件（消费者模式）
+    void drainRings(std::vector<std::shared_ptr<LogRing>> &rings)
+    {
+        bool progress = true;
+        while (progress)
+        {
+            progress = false;
+            for (auto &ring : rings)
             {
-                files.push_back(entry.path().string());
+                progress |= drainRing(*ring, kDrainBatch) > 0;
             }
         }
-        return files.size();
+        writeChunk();
+        flushBatch();
+        io_.submit(); // 整批只进入一次内核
+        startWriteBack();
+
+        // 释放已退出线程的环：先看到 closed 再确认为空，说明之后不会再有记录
+        bool removed = false;
+        for (auto it = rings.begin(); it != rings.end();)
+        {
+            LogRing &ring = **it;
+            if (ring.closed.load(std::memory_order_acquire) &&
+                ring.head.load(std::memory_order_relaxed) == ring.tail.load(std::memory_order_acquire))
+            {
+                it = rings.erase(it);
+                removed = true;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        if (removed)
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                        [](const std::shared_ptr<LogRing> &ring) {
+                                            return ring->closed.load(std::memory_order_acquire) &&
+                                                   ring->head.load(std::memory_order_relaxed) ==
+                                                       ring->tail.load(std::memory_order_acquire);
+                                        }),
+                         rings_.end());
+        }
     }
-    // 辅助函数：删除最旧日志文件
-    void deleteOldestFile()
+    // 辅助函数：从一个环取出最多 maxRecords 条记录（整条消息为单位），格式化后写入；返回取出的记录数
+    size_t drainRing(LogRing &ring, size_t maxRecords)
     {
-        std::vector<std::string> files;
-        for (const auto &entry : std::filesystem::directory_iterator(logDir_))
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+        uint64_t tail = ring.tail.load(std::memory_order_acquire);
+        size_t taken = 0;
+        while (head != tail && taken < maxRecords)
         {
-            if (entry.is_regular_file() && entry.path().extension() == ".log")
+            const Record &first = ring.records[head & (kRingCapacity - 1)];
+            size_t parts = first.parts;
+            std::string_view body(first.text, first.length);
+            if (parts > 1)
+            {
+                payload_.clear();
+                for (size_t i = 0; i < parts; ++i)
+                {
+                    const Record &record = ring.records[(head + i) & (kRingCapacity - 1)];
+                    payload_.append(record.text, record.length);
+                }
+                body = payload_;
+            }
+            if (binaryFile_)
+            {
+                writeBinaryEntry(first.timeNs, first.level, first.formatId, body);
+            }
+            else
             {
-                files.push_back(entry.path().string());
+                entry_.clear();
+                binlog::appendPrefix(entry_, first.timeNs, static_cast<uint8_t>(first.level));
+                const binlog::FormatInfo *info = first.formatId ? binlog::FormatRegistry::instance().get(first.formatId)
+                                                                : nullptr;
+                if (info)
+                    binlog::formatMessage(entry_, info->format, body);
+                else
+                    entry_.append(body.data(), body.size());
+                writeEntry(entry_);
             }
+            head += parts;
+            taken += parts;
         }
-        if (!files.empty())
+        if (taken > 0)
         {
-            std::sort(files.begin(), files.end());
-            std::filesystem::remove(files.front()); // 删除最旧文件
+            ring.head.store(head, std::memory_order_release); // 记录已拷贝完，生产者可以复用
         }
+        return taken;
     }
-    // 辅助函数：写入缓冲区到文件（消费者模式）
-    void flushBuffer()
+    // 辅助函数：写入一条格式化好的日志，必要时轮转文件
+    void writeEntry(std::string &entry)
     {
-        if (buffer_.empty())
-            return;
-        if (!logFile_.is_open())
+        entry.push_back('\n');
+        if (logFd_ < 0 || currentFileSize_ + entry.size() > maxFileSize_)
         {
             openNewFile();
         }
-        while (!buffer_.empty())
+        appendBytes(entry);
+        currentFileSize_ += entry.size();
+    }
+    // 辅助函数：以二进制条目写入一条日志；格式串第一次出现在本文件时先写字典条目
+    void writeBinaryEntry(int64_t timeNs, Level level, uint16_t formatId, std::string_view body)
+    {
+        for (int attempt = 0; attempt < 2; ++attempt)
         {
-            std::string entry = buffer_.front();
-            buffer_.pop();
-            size_t entrySize = entry.size() + 1; // 包括换行符
-            if (currentFileSize_ + entrySize > maxFileSize_)
+            entry_.clear();
+            const binlog::FormatInfo *info = formatId ? binlog::FormatRegistry::instance().get(formatId) : nullptr;
+            if (info)
+            {
+                if (formatId >= formatWritten_.size())
+                    formatWritten_.resize(formatId + 1u, false);
+                if (!formatWritten_[formatId])
+                    binlog::appendDictEntry(entry_, formatId, *info);
+                binlog::appendLogEntry(entry_, timeNs - lastTimeNs_, static_cast<uint8_t>(level), formatId, body);
+            }
+            else
+            {
+                binlog::appendTextEntry(entry_, timeNs - lastTimeNs_, static_cast<uint8_t>(level), body);
+            }
+            // 轮转后字典和时间基准都要重新开始，因此需要重新编码
+            if (attempt == 0 && (logFd_ < 0 || currentFileSize_ + entry_.size() > maxFileSize_))
             {
                 openNewFile();
+                continue;
             }
-            logFile_ << entry << std::endl;
-            currentFileSize_ += entrySize;
+            break;
         }
-        logFile_.flush();
+        if (formatId && formatId < formatWritten_.size())
+            formatWritten_[formatId] = true;
+        lastTimeNs_ = timeNs;
+        appendBytes(entry_);
+        currentFileSize_ += entry_.size();
     }
-    // 辅助函数：打开新日志文件
-    void openNewFile()
+    // 辅助函数：把一段字节追加到当前缓冲区，缓冲区放不下时先写出
+    void appendBytes(std::string_view bytes)
+    {
+        if (bytes.size() > kIOBufferSize)
+        {
+            writeChunk();
+            io_.write(logFd_, std::string(bytes), fileOffset_); // 超长条目单独写
+            fileOffset_ += bytes.size();
+            return;
+        }
+        if (chunk_.data && chunkUsed_ + bytes.size() > chunk_.capacity)
+        {
+            writeChunk();
+        }
+        if (!chunk_.data)
+        {
+            chunk_ = io_.acquire_buffer();
+        }
+        std::memcpy(chunk_.data + chunkUsed_, bytes.data(), bytes.size());
+        chunkUsed_ += bytes.size();
+    }
+    // 辅助函数：把当前缓冲区加入待写批次（缓冲区随之交出），批次满时写出
+    void writeChunk()
+    {
+        if (chunkUsed_ == 0)
+            return;
+        if (batch_.empty())
+            batchOffset_ = fileOffset_;
+        batch_.emplace_back(chunk_, chunkUsed_);
+        fileOffset_ += chunkUsed_;
+        chunk_ = {};
+        chunkUsed_ = 0;
+        if (batch_.size() >= kMaxBatchChunks)
+            flushBatch();
+    }
+    // 辅助函数：批次中的缓冲区在文件中是连续的，合并为一次异步向量写
+    void flushBatch()
+    {
+        if (batch_.empty())
+            return;
+        io_.write_vectored(logFd_, std::move(batch_), batchOffset_);
+        batch_.clear();
+    }
+    // 辅助函数：按 writeBackBytes_ 发起后台回写；只回写上一轮之前的数据，本轮的异步写此时多半还没完成
+    void startWriteBack()
+    {
+        size_t interval = writeBackBytes_.load(std::memory_order_relaxed);
+        if (interval == 0 || logFd_ < 0)
+            return;
+        if (static_cast<size_t>(writeBackEnd_ - writeBackStart_) >= interval)
+        {
+#if defined(__linux__)
+            ::sync_file_range(logFd_, writeBackStart_, writeBackEnd_ - writeBackStart_, SYNC_FILE_RANGE_WRITE);
+#endif
+            writeBackStart_ = writeBackEnd_;
+        }
+        writeBackEnd_ = fileOffset_;
+    }
+    // 辅助函数：关闭当前文件；截断到实际长度以释放预分配但没用到的空间（否则会一直占用磁盘）
+    void closeFile()
     {
-        if (logFile_.is_open())
+        if (preallocated_ && static_cast<size_t>(fileOffset_) < maxFileSize_)
         {
-            logFile_.close();
+            (void)::ftruncate(logFd_, fileOffset_);
         }
-        if (getFileCount() >= maxFiles_)
+        ::close(logFd_);
+        logFd_ = -1;
+    }
+    // 辅助函数：打开新日志文件
+    void openNewFile()
+    {
+        if (logFd_ >= 0)
         {
-            deleteOldestFile();
+            writeChunk();
+            flushBatch();
+            io_.drain(); // 旧文件的异步写全部完成后才能关闭
+            closeFile();
+            segments_.back().size = static_cast<uint64_t>(fileOffset_);
+            closedBytes_ += segments_.back().size;
         }
-        currentFileName_ = generateFileName();
-        logFile_.open(currentFileName_, std::ios::app);
-        if (!logFile_.is_open())
+        pruneSegments();
+        currentFileName_ = generateFileName(binaryFile_ ? ".nlog" : ".log");
+        logFd_ = ::open(currentFileName_.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+        if (logFd_ < 0)
         {
             throw std::runtime_error("Failed to open log file: " + currentFileName_);
         }
+        fileOffset_ = ::lseek(logFd_, 0, SEEK_END); // 与原来的追加模式一致
         currentFileSize_ = 0;
+        writeBackStart_ = writeBackEnd_ = fileOffset_;
+        preallocated_ = false;
+#if defined(__linux__)
+        // KEEP_SIZE：只分配磁盘块、不改变文件长度，读日志的程序看不到多余的零字节
+        preallocated_ = static_cast<size_t>(fileOffset_) < maxFileSize_ &&
+                        ::fallocate(logFd_, FALLOC_FL_KEEP_SIZE, fileOffset_, maxFileSize_ - fileOffset_) == 0;
+#endif
+        segments_.push_back({currentFileName_, 0});
+        if (binaryFile_)
+        {
+            // 每个二进制文件自带文件头和字典，时间戳从 0 开始计差值
+            lastTimeNs_ = 0;
+            formatWritten_.clear();
+            if (fileOffset_ == 0)
+            {
+                appendBytes(std::string_view(binlog::kFileMagic, binlog::kFileMagicSize));
+                currentFileSize_ = binlog::kFileMagicSize;
+            }
+        }
     }
     // 辅助函数：写入线程循环
     void writerLoop()
     {
-        while (!stop_)
+        std::vector<std::shared_ptr<LogRing>> rings; // rings_ 的副本，只在登记变化时更新
+        bool stop = false;
+        while (!stop)
         {
-            std::unique_lock<std::mutex> lock(mtx_);
-            cv_.wait(lock, [this] { return !buffer_.empty() || stop_; });
-            flushBuffer();
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                writerSleeping_.store(true, std::memory_order_relaxed);
+                cv_.wait_for(lock, kFlushInterval, [this] {
+                    return stop_ || !writerSleeping_.load(std::memory_order_relaxed);
+                });
+                writerSleeping_.store(false, std::memory_order_relaxed);
+                stop = stop_;
+                if (ringsChanged_)
+                {
+                    rings = rings_;
+                    ringsChanged_ = false;
+                }
+            }
+            bool binary = output_.load(std::memory_order_relaxed) == Output::Binary;
+            if (binary != binaryFile_)
+            {
+                // 输出格式只在两轮之间切换，保证一个文件里只有一种格式
+                binaryFile_ = binary;
+                if (logFd_ >= 0)
+                    openNewFile();
+            }
+            drainRings(rings); // 停止时这也是最后一次排空
         }
-        flushBuffer(); // 最后一次刷新
     }
 };
 
+// 延迟格式化日志：格式串必须是字符串字面量（只登记一次，之后按 ID 引用）
+#define LOG_FMT(level, format, ...)                                                                      \
+    do                                                                                                   \
+    {                                                                                                    \
+        static const uint16_t logFormatId_ = binlog::FormatRegistry::instance().add(format, __FILE__, __LINE__); \
+        Logger::getInstance().logFormat(level, logFormatId_, ##__VA_ARGS__);                             \
+    } while (0)
+
 #endif // LOGGER_H
\ No newline at end of file
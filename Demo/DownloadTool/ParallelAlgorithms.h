@@ -0,0 +1,282 @@
+#ifndef PARALLEL_ALGORITHMS_H
+#define PARALLEL_ALGORITHMS_H
+
+/*
+ **************** 并行算法 ****************
+ 设计目标：
+    1. 在 ThreadPool 之上提供 parallel_for / parallel_reduce / parallel_transform / parallel_scan
+    2. 递归二分区间：大区间一分为二，右半部分提交给线程池，左半部分继续在当前线程拆分/执行
+    3. 粒度自适应：默认按"每个线程约 8 块"由区间长度和线程数推算，也可显式指定
+    4. 调用线程不阻塞在 future 上，而是帮助线程池执行排队任务，直到本次调用的所有块完成
+    5. 任一块抛出异常时，后续尚未开始的块被跳过，第一个异常在调用线程重新抛出
+    6. fork_join(pool, left, right)：两个分支并行执行后汇合，等待时边等边干（ThreadPool::help_until），
+       可以在任务内部任意深度地递归调用；parallel_sort 是基于它的并行快速排序
+*/
+
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// 一次并行调用的共享状态：未完成块计数 + 第一个异常
+class ParallelRegion {
+public:
+    explicit ParallelRegion(ThreadPool& pool) : pool_(pool), pending_(0), failed_(false) {}
+
+    ThreadPool& pool() { return pool_; }
+    bool failed() const { return failed_.load(std::memory_order_relaxed); }
+
+    void fail(std::exception_ptr e) {
+        std::lock_guard<std::mutex> lock(errorMtx_);
+        if (!error_) error_ = e;
+        failed_.store(true, std::memory_order_relaxed);
+    }
+
+    void addPending() { pending_.fetch_add(1, std::memory_order_relaxed); }
+    void finishOne() { pending_.fetch_sub(1, std::memory_order_acq_rel); }
+
+    // 帮助执行线程池中的任务直到所有块完成，然后重新抛出第一个异常
+    void wait() {
+        pool_.help_until([this] { return pending_.load(std::memory_order_acquire) == 0; });
+        if (error_) std::rethrow_exception(error_);
+    }
+
+private:
+    ThreadPool& pool_;
+    std::atomic<size_t> pending_;
+    std::atomic<bool> failed_;
+    std::mutex errorMtx_;
+    std::exception_ptr error_;
+};
+
+// 默认粒度：目标是每个参与线程（工作线程 + 调用线程）约 8 块，兼顾负载均衡和调度开销
+inline size_t defaultGrain(ThreadPool& pool, size_t n) {
+    size_t chunks = 8 * (pool.thread_count() + 1);
+    return std::max<size_t>(1, (n + chunks - 1) / chunks);
+}
+
+// 递归二分 [begin, end)：右半部分交给线程池，左半部分继续拆分，不大于 grain 时执行 body(b, e)。
+// 提交失败（线程池已停止、队列已满）时右半部分就地执行：已提交的块引用着调用方栈上的 region 和 body，
+// 不能让异常越过 region.wait() 展开调用方的栈帧
+template<typename RangeBody>
+void splitRange(ParallelRegion& region, size_t begin, size_t end, size_t grain, RangeBody& body) {
+    while (end - begin > grain) {
+        size_t mid = begin + (end - begin) / 2;
+        region.addPending();
+        bool posted = true;
+        try {
+            region.pool().post([&region, mid, end, grain, &body] {
+                splitRange(region, mid, end, grain, body);
+            });
+        } catch (...) {
+            posted = false;
+        }
+        if (!posted) splitRange(region, mid, end, grain, body);
+        end = mid;
+    }
+    if (!region.failed()) {
+        try {
+            body(begin, end);
+        } catch (...) {
+            region.fail(std::current_exception());
+        }
+    }
+    region.finishOne();
+}
+
+// 对 [begin, end) 的每个子区间调用 body(b, e)，子区间长度不超过 grain（0 表示自动选择）
+template<typename RangeBody>
+void parallel_for_range(ThreadPool& pool, size_t begin, size_t end, RangeBody&& body, size_t grain = 0) {
+    if (begin >= end) return;
+    if (grain == 0) grain = defaultGrain(pool, end - begin);
+    ParallelRegion region(pool);
+    region.addPending();
+    splitRange(region, begin, end, grain, body);
+    region.wait();
+}
+
+// 对 [begin, end) 中的每个下标 i 调用 body(i)
+template<typename Body>
+void parallel_for(ThreadPool& pool, size_t begin, size_t end, Body&& body, size_t grain = 0) {
+    parallel_for_range(pool, begin, end, [&body](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) body(i);
+    }, grain);
+}
+
+// 归约：result = reduce(... reduce(identity, map(begin)) ..., map(end - 1))
+// 各块的部分结果按块顺序合并，reduce 只需满足结合律（不要求交换律）
+template<typename T, typename Map, typename Reduce>
+T parallel_reduce(ThreadPool& pool, size_t begin, size_t end, T identity, Map&& map, Reduce&& reduce,
+                  size_t grain = 0) {
+    if (begin >= end) return identity;
+    size_t n = end - begin;
+    if (grain == 0) grain = defaultGrain(pool, n);
+    size_t numChunks = (n + grain - 1) / grain;
+    std::vector<T> partials(numChunks, identity);
+
+    parallel_for_range(pool, 0, numChunks, [&](size_t cb, size_t ce) {
+        for (size_t c = cb; c < ce; ++c) {
+            size_t b = begin + c * grain;
+            size_t e = std::min(end, b + grain);
+            T acc = identity;
+            for (size_t i = b; i < e; ++i) acc = reduce(std::move(acc), map(i));
+            partials[c] = std::move(acc);
+        }
+    }, 1);
+
+    T result = identity;
+    for (auto& partial : partials) result = reduce(std::move(result), std::move(partial));
+    return result;
+}
+
+// 变换：out[i] = op(first[i])，要求随机访问迭代器；返回输出区间的尾后迭代器
+template<typename InputIt, typename OutputIt, typename UnaryOp>
+OutputIt parallel_transform(ThreadPool& pool, InputIt first, InputIt last, OutputIt out, UnaryOp&& op,
+                            size_t grain = 0) {
+    size_t n = static_cast<size_t>(std::distance(first, last));
+    parallel_for_range(pool, 0, n, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) out[i] = op(first[i]);
+    }, grain);
+    return out + n;
+}
+
+// 包含式前缀扫描：out[i] = op(first[0], ..., first[i])，op 需满足结合律
+// 两遍算法：第一遍并行求每块的总和，串行求块前缀，第二遍并行在每块内带偏移扫描
+template<typename InputIt, typename OutputIt, typename BinaryOp>
+OutputIt parallel_scan(ThreadPool& pool, InputIt first, InputIt last, OutputIt out, BinaryOp&& op,
+                       size_t grain = 0) {
+    using T = typename std::iterator_traits<InputIt>::value_type;
+    size_t n = static_cast<size_t>(std::distance(first, last));
+    if (n == 0) return out;
+    if (grain == 0) grain = defaultGrain(pool, n);
+    size_t numChunks = (n + grain - 1) / grain;
+
+    std::vector<T> sums(numChunks);
+    parallel_for(pool, 0, numChunks, [&](size_t c) {
+        size_t b = c * grain;
+        size_t e = std::min(n, b + grain);
+        T acc = first[b];
+        for (size_t i = b + 1; i < e; ++i) acc = op(acc, first[i]);
+        sums[c] = acc;
+    }, 1);
+
+    // offsets[c]：第 c 块之前所有元素的归约结果（c >= 1 时有效），串行计算，只有 numChunks 项
+    std::vector<T> offsets(numChunks);
+    for (size_t c = 1; c < numChunks; ++c) {
+        offsets[c] = c == 1 ? sums[0] : op(offsets[c - 1], sums[c - 1]);
+    }
+
+    parallel_for(pool, 0, numChunks, [&](size_t c) {
+        size_t b = c * grain;
+        size_t e = std::min(n, b + grain);
+        T acc = c == 0 ? first[b] : op(offsets[c], first[b]);
+        out[b] = acc;
+        for (size_t i = b + 1; i < e; ++i) {
+            acc = op(acc, first[i]);
+            out[i] = acc;
+        }
+    }, 1);
+    return out + n;
+}
+
+// fork_join 一个分支的结果类型：返回 void 的分支用 std::monostate 占位
+template<typename F>
+using ForkResult = std::conditional_t<std::is_void<std::invoke_result_t<std::decay_t<F>&>>::value, std::monostate,
+                                      std::invoke_result_t<std::decay_t<F>&>>;
+
+template<typename F>
+ForkResult<F> invokeBranch(F& f) {
+    if constexpr (std::is_void<std::invoke_result_t<F&>>::value) {
+        f();
+        return {};
+    } else {
+        return f();
+    }
+}
+
+// 并行执行 left() 和 right()：right 提交给线程池，left 在当前线程执行，然后边等边干直到 right 完成。
+// 在工作线程内调用时 right 进入本线程的本地槽位，没有被窃取的话由本线程在等待时直接执行。
+// 返回 {left 的结果, right 的结果}；两个分支都会执行完，再重新抛出第一个异常（left 优先）。
+// right 提交失败时在 left 之后就地执行
+template<typename Left, typename Right>
+auto fork_join(ThreadPool& pool, Left&& left, Right&& right) -> std::pair<ForkResult<Left>, ForkResult<Right>> {
+    std::optional<ForkResult<Right>> rightResult;
+    std::exception_ptr rightError;
+    std::atomic<bool> rightDone{false};
+    auto runRight = [&] {
+        try {
+            rightResult.emplace(invokeBranch(right));
+        } catch (...) {
+            rightError = std::current_exception();
+        }
+        rightDone.store(true, std::memory_order_release);
+    };
+    bool posted = true;
+    try {
+        pool.post([&runRight] { runRight(); });
+    } catch (...) {
+        posted = false;
+    }
+
+    std::optional<ForkResult<Left>> leftResult;
+    std::exception_ptr leftError;
+    try {
+        leftResult.emplace(invokeBranch(left));
+    } catch (...) {
+        leftError = std::current_exception();
+    }
+    if (posted) {
+        pool.help_until([&rightDone] { return rightDone.load(std::memory_order_acquire); });
+    } else {
+        runRight();
+    }
+
+    if (leftError) std::rethrow_exception(leftError);
+    if (rightError) std::rethrow_exception(rightError);
+    return {std::move(*leftResult), std::move(*rightResult)};
+}
+
+// 三数取中
+template<typename T, typename Compare>
+const T& medianOfThree(const T& a, const T& b, const T& c, Compare& comp) {
+    if (comp(a, b)) return comp(b, c) ? b : (comp(a, c) ? c : a);
+    return comp(a, c) ? a : (comp(b, c) ? c : b);
+}
+
+// 并行快速排序的递归部分：三数取中，三路划分（小于 / 等于 / 大于枢轴），两侧用 fork_join 并行；
+// 区间不大于 grain 或递归过深（枢轴持续选得很差）时退化为 std::sort
+template<typename RandomIt, typename Compare>
+void parallelSortRange(ThreadPool& pool, RandomIt first, RandomIt last, Compare& comp, size_t grain, int depthLimit) {
+    if (static_cast<size_t>(last - first) <= grain || depthLimit == 0) {
+        std::sort(first, last, comp);
+        return;
+    }
+    auto pivot = medianOfThree(*first, *(first + (last - first) / 2), *(last - 1), comp);
+    RandomIt lessEnd = std::partition(first, last, [&](const auto& x) { return comp(x, pivot); });
+    RandomIt equalEnd = std::partition(lessEnd, last, [&](const auto& x) { return !comp(pivot, x); });
+    fork_join(pool, [&] { parallelSortRange(pool, first, lessEnd, comp, grain, depthLimit - 1); },
+              [&] { parallelSortRange(pool, equalEnd, last, comp, grain, depthLimit - 1); });
+}
+
+// 并行排序 [first, last)（不稳定）；grain 为 0 时按线程数推算，且不小于 1024 个元素
+template<typename RandomIt, typename Compare = std::less<>>
+void parallel_sort(ThreadPool& pool, RandomIt first, RandomIt last, Compare comp = Compare(), size_t grain = 0) {
+    size_t n = static_cast<size_t>(last - first);
+    if (n < 2) return;
+    if (grain == 0) grain = std::max<size_t>(1024, defaultGrain(pool, n));
+    int depthLimit = 0;
+    for (size_t m = n; m > 1; m >>= 1) depthLimit += 2;   // 约 2 * log2(n)
+    parallelSortRange(pool, first, last, comp, grain, depthLimit);
+}
+
+#endif // PARALLEL_ALGORITHMS_H
@@ -0,0 +1,129 @@
+#ifndef PARKER_H
+#define PARKER_H
+
+/*
+ **************** 线程休眠器（Parker） ****************
+ 设计目标：
+    1. 每个工作线程一个：park() 休眠直到被 unpark()，unpark() 只唤醒这一个线程（没有惊群）
+    2. 通知以"令牌"保存：先 unpark 后 park 时 park 立即返回，不会丢失唤醒，调用方无需持锁配对
+    3. Linux 上直接用 futex：三态 EMPTY / NOTIFIED / PARKED，unpark 只在对方确实睡着时才进入内核，
+       park 在已有令牌时也不进入内核；其他平台退化为 mutex + condition_variable
+    4. cpuRelax()：自旋等待时的 pause / yield 指令，降低自旋对超线程兄弟和总线的干扰
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#if defined(__linux__)
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// 自旋等待提示：x86 为 pause，ARM 为 yield，其他平台为空
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+class Parker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Parker() = default;
+    Parker(const Parker&) = delete;
+    Parker& operator=(const Parker&) = delete;
+
+    // 休眠直到被 unpark（已有令牌时立即返回）；可能伪唤醒，调用方需要重新检查条件
+    void park() { parkUntil(nullptr); }
+
+    // 同上，但最多等到 deadline；返回 false 表示超时且没有收到通知
+    bool park_until(Clock::time_point deadline) { return parkUntil(&deadline); }
+
+    // 放入令牌；对方正在休眠时唤醒它
+    void unpark() {
+#if defined(__linux__)
+        if (state_.exchange(kNotified, std::memory_order_release) == kParked) {
+            futex(FUTEX_WAKE_PRIVATE, 1, nullptr);
+        }
+#else
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (state_.exchange(kNotified, std::memory_order_release) != kParked) return;
+        }
+        cv_.notify_one();
+#endif
+    }
+
+private:
+    static constexpr uint32_t kEmpty = 0;
+    static constexpr uint32_t kNotified = 1;
+    static constexpr uint32_t kParked = 2;
+
+    bool parkUntil(const Clock::time_point* deadline) {
+        // 已有令牌：消耗后直接返回，不进入内核
+        if (state_.exchange(kEmpty, std::memory_order_acquire) == kNotified) return true;
+#if defined(__linux__)
+        uint32_t expected = kEmpty;
+        if (!state_.compare_exchange_strong(expected, kParked, std::memory_order_acquire)) {
+            state_.store(kEmpty, std::memory_order_relaxed);    // 两次操作之间收到了通知
+            return true;
+        }
+        while (true) {
+            if (deadline) {
+                auto remaining = *deadline - Clock::now();
+                if (remaining <= Clock::duration::zero()) break;
+                auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count();
+                timespec timeout{static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000)};
+                futex(FUTEX_WAIT_PRIVATE, kParked, &timeout);
+            } else {
+                futex(FUTEX_WAIT_PRIVATE, kParked, nullptr);
+            }
+            expected = kNotified;
+            if (state_.compare_exchange_strong(expected, kEmpty, std::memory_order_acquire)) return true;
+            // 伪唤醒（EINTR 等）：状态仍为 PARKED，继续等待
+        }
+        // 超时：退出 PARKED；若恰好在此刻收到通知，仍算作被唤醒
+        return state_.exchange(kEmpty, std::memory_order_acquire) == kNotified;
+#else
+        std::unique_lock<std::mutex> lock(mtx_);
+        uint32_t expected = kEmpty;
+        if (!state_.compare_exchange_strong(expected, kParked, std::memory_order_acquire)) {
+            state_.store(kEmpty, std::memory_order_relaxed);
+            return true;
+        }
+        while (state_.load(std::memory_order_acquire) != kNotified) {
+            if (!deadline) {
+                cv_.wait(lock);
+            } else if (cv_.wait_until(lock, *deadline) == std::cv_status::timeout) {
+                break;
+            }
+        }
+        return state_.exchange(kEmpty, std::memory_order_acquire) == kNotified;
+#endif
+    }
+
+#if defined(__linux__)
+    long futex(int op, uint32_t value, const timespec* timeout) {
+        static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain uint32_t");
+        return syscall(SYS_futex, reinterpret_cast<uint32_t*>(&state_), op, value, timeout, nullptr, 0);
+    }
+#else
+    std::mutex mtx_;
+    std::condition_variable cv_;
+#endif
+
+    std::atomic<uint32_t> state_{kEmpty};
+};
+
+#endif // PARKER_H
@@ -0,0 +1,101 @@
+#ifndef POOL_METRICS_H
+#define POOL_METRICS_H
+
+/*
+ **************** 线程池指标输出 ****************
+ 设计目标：
+    1. 把 ThreadPool::stats() 的快照格式化为一行汇总 + 每个工作线程一行，便于 grep 和比较
+    2. 借助线程池自身的定时任务（schedule_every）定期写入 Logger，不额外创建线程
+    3. 每次输出与上一次快照的差值（区间内的任务数、空闲比例、竞争次数），分位数取累计值
+*/
+
+#include "ThreadPool.h"
+#include "Logger.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+// 纳秒 -> 易读的字符串（ns / us / ms / s）
+inline std::string formatNanos(uint64_t ns) {
+    char text[32];
+    if (ns < 1000) {
+        std::snprintf(text, sizeof(text), "%lluns", static_cast<unsigned long long>(ns));
+    } else if (ns < 1000 * 1000) {
+        std::snprintf(text, sizeof(text), "%.1fus", ns / 1e3);
+    } else if (ns < 1000ull * 1000 * 1000) {
+        std::snprintf(text, sizeof(text), "%.1fms", ns / 1e6);
+    } else {
+        std::snprintf(text, sizeof(text), "%.2fs", ns / 1e9);
+    }
+    return text;
+}
+
+inline std::string formatWorkerStats(const ThreadPool::WorkerStats& w) {
+    char text[448];
+    std::snprintf(text, sizeof(text),
+                  "executed=%llu wait(p50/p99/p999)=%s/%s/%s run(p50/p99)=%s/%s depth(p50/p99)=%llu/%llu "
+                  "idle=%s emptyPolls=%llu spinHits=%llu parks=%llu local=%llu lifo=%llu steals=%llu "
+                  "lockContended=%llu lockWait=%s",
+                  static_cast<unsigned long long>(w.executed),
+                  formatNanos(w.waitNs.percentile(0.5)).c_str(), formatNanos(w.waitNs.percentile(0.99)).c_str(),
+                  formatNanos(w.waitNs.percentile(0.999)).c_str(),
+                  formatNanos(w.runNs.percentile(0.5)).c_str(), formatNanos(w.runNs.percentile(0.99)).c_str(),
+                  static_cast<unsigned long long>(w.queueDepth.percentile(0.5)),
+                  static_cast<unsigned long long>(w.queueDepth.percentile(0.99)),
+                  formatNanos(w.idleNs).c_str(), static_cast<unsigned long long>(w.emptyPolls),
+                  static_cast<unsigned long long>(w.spinHits), static_cast<unsigned long long>(w.parks),
+                  static_cast<unsigned long long>(w.localPushes), static_cast<unsigned long long>(w.lifoHits),
+                  static_cast<unsigned long long>(w.steals),
+                  static_cast<unsigned long long>(w.lockContended), formatNanos(w.lockWaitNs).c_str());
+    return text;
+}
+
+// 汇总行：线程数、当前队列深度，以及与上一次快照相比的区间吞吐和空闲比例
+inline std::string formatPoolStats(const ThreadPool::Stats& now, const ThreadPool::Stats* previous,
+                                   std::chrono::nanoseconds interval) {
+    uint64_t executed = now.total.executed - (previous ? previous->total.executed : 0);
+    uint64_t idleNs = now.total.idleNs - (previous ? previous->total.idleNs : 0);
+    double seconds = std::chrono::duration<double>(interval).count();
+    double busy = 0.0;
+    if (seconds > 0 && now.liveThreads > 0) {
+        busy = 1.0 - (idleNs / 1e9) / (seconds * static_cast<double>(now.liveThreads));
+        if (busy < 0) busy = 0;
+    }
+    char text[256];
+    std::snprintf(text, sizeof(text),
+                  "线程池: live=%zu idle=%zu(spin=%zu park=%zu) queued=%zu rate=%.0f/s busy=%.0f%% producerLockContended=%llu | ",
+                  now.liveThreads, now.idleThreads, now.spinningThreads, now.parkedThreads, now.queueDepth, seconds > 0 ? executed / seconds : 0.0,
+                  busy * 100, static_cast<unsigned long long>(now.producerLockContended));
+    return text + formatWorkerStats(now.total);
+}
+
+// 每隔 period 把线程池指标写入日志（汇总行用 level，每个工作线程一行用 DEBUG）；返回的句柄可用 cancel_timer 停止
+inline TimerHandle startStatsDump(ThreadPool& pool, std::chrono::milliseconds period,
+                                  Logger::Level level = Logger::Level::INFO) {
+    struct DumpState {
+        ThreadPool::Stats previous;
+        std::chrono::steady_clock::time_point previousAt;
+        bool hasPrevious = false;
+    };
+    auto state = std::make_shared<DumpState>();
+    return pool.schedule_every(period, [&pool, state, level] {
+        auto at = std::chrono::steady_clock::now();
+        ThreadPool::Stats stats = pool.stats();
+        auto interval = state->hasPrevious ? at - state->previousAt : std::chrono::steady_clock::duration::zero();
+        Logger& logger = Logger::getInstance();
+        logger.log(level, formatPoolStats(stats, state->hasPrevious ? &state->previous : nullptr,
+                                          std::chrono::duration_cast<std::chrono::nanoseconds>(interval)));
+        for (size_t i = 0; i < stats.workers.size(); ++i) {
+            if (!stats.workers[i].active && stats.workers[i].executed == 0) continue;
+            logger.log(Logger::Level::DEBUG, "  worker[" + std::to_string(i) + "] cpu=" +
+                                             std::to_string(stats.workers[i].cpu) + " " +
+                                             formatWorkerStats(stats.workers[i]));
+        }
+        state->previous = std::move(stats);
+        state->previousAt = at;
+        state->hasPrevious = true;
+    });
+}
+
+#endif // POOL_METRICS_H
@@ -0,0 +1,140 @@
+#ifndef STOP_TOKEN_H
+#define STOP_TOKEN_H
+
+/*
+ **************** 协作式取消（StopSource / StopToken） ****************
+ 设计目标：
+    1. 接口与 C++20 的 std::stop_source / std::stop_token / std::stop_callback 一致，但只需要 C++17
+    2. StopSource 发出取消请求，StopToken 只读：任务轮询 stop_requested()，自行决定在哪里退出
+    3. StopCallback：请求取消时执行的回调（例如唤醒阻塞中的操作）；注册时已经取消则立即执行；
+       析构时自动注销，若回调正在另一个线程执行则只等这一个回调结束（与 std::stop_callback 相同），
+       析构后回调保证不再运行；回调里可以注销其他回调
+    4. 共享状态用 shared_ptr 管理，token 可以随任务拷贝到任意线程；默认构造的 token 永远不会被取消
+*/
+
+#include "Task.h"
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+// 任务在开始执行前发现已被取消时，其 future 得到此异常
+class TaskCancelledError : public std::runtime_error {
+public:
+    TaskCancelledError() : std::runtime_error("Task was cancelled") {}
+};
+
+namespace detail {
+
+struct StopState {
+    using Callback = UniqueFunction<void()>;
+
+    std::atomic<bool> requested{false};
+    std::mutex mtx;
+    std::list<Callback*> callbacks;                 // 已注册、尚未执行的回调
+    Callback* running = nullptr;                    // 正在执行的回调（受 mtx 保护）
+    std::thread::id runner;                         // 执行回调的线程
+    std::condition_variable runningDone;            // running 执行完毕时通知
+
+    // 返回 true 表示本次调用发出了取消请求（此前未取消）
+    bool requestStop() {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (requested.exchange(true)) return false;
+        runner = std::this_thread::get_id();
+        while (!callbacks.empty()) {
+            running = callbacks.front();
+            callbacks.pop_front();
+            lock.unlock();
+            (*running)();           // 不持锁执行：回调里可以再注册 / 注销其他回调
+            lock.lock();
+            running = nullptr;
+            runningDone.notify_all();
+        }
+        return true;
+    }
+
+    // 注册回调；已经取消时返回 false，由调用方立即执行
+    bool add(Callback* callback) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (requested.load()) return false;
+        callbacks.push_back(callback);
+        return true;
+    }
+
+    void remove(Callback* callback) {
+        std::unique_lock<std::mutex> lock(mtx);
+        for (auto it = callbacks.begin(); it != callbacks.end(); ++it) {
+            if (*it == callback) {
+                callbacks.erase(it);
+                return;
+            }
+        }
+        // 不在列表中：要么从未注册（注册时已取消），要么已被取出执行；
+        // 后者正在另一个线程上执行时只等它本身结束，不等后面的回调（在回调内部注销自己则不能等）
+        if (running == callback && runner != std::this_thread::get_id()) {
+            runningDone.wait(lock, [this, callback] { return running != callback; });
+        }
+    }
+};
+
+} // namespace detail
+
+class StopToken {
+public:
+    StopToken() noexcept = default;     // 永远不会被取消
+
+    bool stop_requested() const noexcept {
+        return state_ && state_->requested.load(std::memory_order_acquire);
+    }
+
+    // 是否可能被取消（关联了 StopSource）
+    bool stop_possible() const noexcept { return static_cast<bool>(state_); }
+
+private:
+    friend class StopSource;
+    friend class StopCallback;
+    explicit StopToken(std::shared_ptr<detail::StopState> state) : state_(std::move(state)) {}
+
+    std::shared_ptr<detail::StopState> state_;
+};
+
+class StopSource {
+public:
+    StopSource() : state_(std::make_shared<detail::StopState>()) {}
+
+    StopToken get_token() const noexcept { return StopToken(state_); }
+
+    // 请求取消，并在当前线程依次执行已注册的回调；只有第一次调用返回 true
+    bool request_stop() { return state_->requestStop(); }
+
+    bool stop_requested() const noexcept { return state_->requested.load(std::memory_order_acquire); }
+
+private:
+    std::shared_ptr<detail::StopState> state_;
+};
+
+class StopCallback {
+public:
+    template<typename F>
+    StopCallback(const StopToken& token, F&& callback)
+        : state_(token.state_), callback_(std::forward<F>(callback)) {
+        if (state_ && !state_->add(&callback_)) callback_();   // 已经取消：立即执行
+    }
+
+    ~StopCallback() {
+        if (state_) state_->remove(&callback_);
+    }
+
+    StopCallback(const StopCallback&) = delete;
+    StopCallback& operator=(const StopCallback&) = delete;
+
+private:
+    std::shared_ptr<detail::StopState> state_;
+    detail::StopState::Callback callback_;
+};
+
+#endif // STOP_TOKEN_H
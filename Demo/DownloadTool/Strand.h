@@ -0,0 +1,229 @@
+#ifndef STRAND_H
+#define STRAND_H
+
+/*
+ **************** 串行执行器（Strand / KeyedExecutor） ****************
+ 设计目标：
+    1. Strand：提交到同一个 Strand 的任务按 FIFO 顺序执行，且任意时刻最多一个在运行（互不重叠），
+       不同 Strand 的任务在 ThreadPool 上并行；不需要专用线程，也不需要全局互斥锁
+    2. 执行方式：队列由空变非空时向线程池提交一个"排空任务"，由它依次执行排队中的任务；
+       锁只保护入队 / 出队，执行任务时不持有任何锁
+    3. 排空任务每次最多执行 kStrandBatch 个任务，之后用 ThreadPool::post_global 把自己重新提交到全局队列末尾
+       （不进入当前工作线程的本地槽位），繁忙的 Strand 不会长期占住一个工作线程，其他任务也能得到执行
+    4. KeyedExecutor<Key>：按 key 串行（每个文件的日志、每个 URL 的通知……），不同 key 并行；
+       key 的状态只在有排队或正在执行的任务时存在，排空后立即删除，
+       因此可以有数百万个大多空闲的 key；按哈希分片加锁，不同分片的提交互不竞争
+    5. 状态由 shared_ptr 持有，Strand / KeyedExecutor 先于排队任务析构时，剩余任务仍会执行完
+    6. post 的任务抛出的异常被拦下并计数（task_exceptions()），后续任务照常执行；需要结果或异常时使用 async
+*/
+
+#include "ThreadPool.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+constexpr size_t kStrandBatch = 32;   // 排空任务每轮最多执行的任务数，之后让出工作线程
+
+// 排空任务执行一个排队的任务：异常在这里拦下并计数，排空任务照常继续（否则 scheduled 标记 /
+// 忙碌 key 的状态无人清除，之后提交到同一个 Strand / key 的任务永远不会执行）
+inline void runStrandTask(ThreadPool::Task& task, std::atomic<uint64_t>& exceptions) noexcept {
+    try {
+        task();
+    } catch (...) {
+        exceptions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+class Strand {
+public:
+    using Task = ThreadPool::Task;
+
+    explicit Strand(ThreadPool& pool) : state_(std::make_shared<State>(pool)) {}
+
+    // 提交任务：排在本 Strand 之前提交的所有任务之后执行
+    template<typename F>
+    void post(F&& f) {
+        State::post(state_, Task(std::forward<F>(f)));
+    }
+
+    // 提交任务并返回 Future：then() 的后续任务默认回到本 Strand 上执行
+    template<typename F, typename... Args>
+    auto async(F&& f, Args&&... args) -> Future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>> {
+        using ReturnType = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+        Promise<ReturnType> promise(executor());
+        Future<ReturnType> result = promise.get_future();
+        post([promise = std::move(promise), call = BoundCall<std::decay_t<F>, std::decay_t<Args>...>(
+                  std::forward<F>(f), std::forward<Args>(args)...)]() mutable {
+            promise.set_from(std::move(call));
+        });
+        return result;
+    }
+
+    // 把本 Strand 包装为 Future 使用的执行器（执行器不持有 Strand，使用期间 Strand 必须存活）
+    Executor executor() {
+        return Executor{this, [](void* strand, Task&& task) { static_cast<Strand*>(strand)->post(std::move(task)); }};
+    }
+
+    // 当前排队（不含正在执行）的任务数，近似值
+    size_t pending() const {
+        std::lock_guard<std::mutex> lock(state_->mtx);
+        return state_->tasks.size();
+    }
+
+    // post 的任务抛出的异常数
+    uint64_t task_exceptions() const { return state_->exceptions.load(std::memory_order_relaxed); }
+
+private:
+    struct State {
+        explicit State(ThreadPool& p) : pool(p) {}
+
+        ThreadPool& pool;
+        mutable std::mutex mtx;
+        std::deque<Task> tasks;
+        bool scheduled = false;     // 是否已有排空任务在线程池中（排队或正在执行）
+        std::atomic<uint64_t> exceptions{0};
+
+        static void post(const std::shared_ptr<State>& state, Task&& task) {
+            {
+                std::lock_guard<std::mutex> lock(state->mtx);
+                state->tasks.push_back(std::move(task));
+                if (state->scheduled) return;
+                state->scheduled = true;
+            }
+            schedule(state);
+        }
+
+        static void schedule(std::shared_ptr<State> state) {
+            ThreadPool& pool = state->pool;
+            pool.post([state = std::move(state)]() mutable { drain(std::move(state)); });
+        }
+
+        static void drain(std::shared_ptr<State> state) {
+            for (size_t n = 0; n < kStrandBatch; ++n) {
+                Task task;
+                {
+                    std::lock_guard<std::mutex> lock(state->mtx);
+                    if (state->tasks.empty()) {
+                        state->scheduled = false;
+                        return;
+                    }
+                    task = std::move(state->tasks.front());
+                    state->tasks.pop_front();
+                }
+                runStrandTask(task, state->exceptions);
+            }
+            // 还有任务：排到全局队列末尾，保持 scheduled
+            ThreadPool& pool = state->pool;
+            pool.post_global([state = std::move(state)]() mutable { drain(std::move(state)); });
+        }
+    };
+
+    std::shared_ptr<State> state_;
+};
+
+// 按 key 串行的执行器；Key 需可哈希、可比较相等、可拷贝
+template<typename Key, typename Hash = std::hash<Key>, size_t NumShards = 64>
+class KeyedExecutor {
+public:
+    using Task = ThreadPool::Task;
+
+    explicit KeyedExecutor(ThreadPool& pool) : state_(std::make_shared<State>(pool)) {}
+
+    // 提交任务：与同一 key 之前提交的任务按 FIFO 串行执行，不同 key 并行
+    template<typename F>
+    void post(const Key& key, F&& f) {
+        State::post(state_, key, Task(std::forward<F>(f)));
+    }
+
+    // 提交任务并返回 Future（后续 then() 默认在线程池上执行，不再绑定 key）
+    template<typename F, typename... Args>
+    auto async(const Key& key, F&& f, Args&&... args)
+        -> Future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>> {
+        using ReturnType = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+        Promise<ReturnType> promise(state_->pool.executor());
+        Future<ReturnType> result = promise.get_future();
+        post(key, [promise = std::move(promise), call = BoundCall<std::decay_t<F>, std::decay_t<Args>...>(
+                       std::forward<F>(f), std::forward<Args>(args)...)]() mutable {
+            promise.set_from(std::move(call));
+        });
+        return result;
+    }
+
+    // post 的任务抛出的异常数
+    uint64_t task_exceptions() const { return state_->exceptions.load(std::memory_order_relaxed); }
+
+    // 当前有排队或正在执行任务的 key 数（空闲 key 不占内存）
+    size_t active_keys() const {
+        size_t total = 0;
+        for (const Shard& shard : state_->shards) {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            total += shard.active.size();
+        }
+        return total;
+    }
+
+private:
+    struct Shard {
+        mutable std::mutex mtx;
+        std::unordered_map<Key, std::deque<Task>, Hash> active;    // 只包含忙碌的 key
+    };
+
+    struct State {
+        explicit State(ThreadPool& p) : pool(p) {}
+
+        ThreadPool& pool;
+        std::array<Shard, NumShards> shards;
+        std::atomic<uint64_t> exceptions{0};
+
+        Shard& shardOf(const Key& key) { return shards[Hash()(key) % NumShards]; }
+
+        static void post(const std::shared_ptr<State>& state, const Key& key, Task&& task) {
+            Shard& shard = state->shardOf(key);
+            std::deque<Task>* queue;
+            {
+                std::lock_guard<std::mutex> lock(shard.mtx);
+                auto [it, inserted] = shard.active.try_emplace(key);
+                it->second.push_back(std::move(task));
+                if (!inserted) return;      // 已有排空任务负责这个 key
+                queue = &it->second;        // 节点式容器：rehash 不影响元素地址，直到 drain 把它删除
+            }
+            schedule(state, key, queue);
+        }
+
+        static void schedule(std::shared_ptr<State> state, const Key& key, std::deque<Task>* queue) {
+            ThreadPool& pool = state->pool;
+            pool.post([state = std::move(state), key, queue]() mutable { drain(std::move(state), key, queue); });
+        }
+
+        static void drain(std::shared_ptr<State> state, const Key& key, std::deque<Task>* queue) {
+            Shard& shard = state->shardOf(key);
+            for (size_t n = 0; n < kStrandBatch; ++n) {
+                Task task;
+                {
+                    std::lock_guard<std::mutex> lock(shard.mtx);
+                    if (queue->empty()) {
+                        shard.active.erase(key);    // key 变为空闲：释放其状态
+                        return;
+                    }
+                    task = std::move(queue->front());
+                    queue->pop_front();
+                }
+                runStrandTask(task, state->exceptions);
+            }
+            // 还有任务：排到全局队列末尾，key 保持忙碌
+            ThreadPool& pool = state->pool;
+            pool.post_global([state = std::move(state), key, queue]() mutable { drain(std::move(state), key, queue); });
+        }
+    };
+
+    std::shared_ptr<State> state_;
+};
+
+#endif // STRAND_H
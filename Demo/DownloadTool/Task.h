@@ -0,0 +1,348 @@
+#ifndef TASK_H
+#define TASK_H
+
+/*
+ **************** 任务类型 ****************
+ 设计目标：
+    1. UniqueFunction：只可移动的类型擦除可调用对象，小对象直接存放在内联缓冲区（不分配堆内存）
+    2. PromiseTask：把可调用对象和 std::promise 融合为一个对象，整体放进 UniqueFunction
+    3. RecyclingAllocator：promise 共享状态的分配器，按大小分级的线程本地空闲链表复用内存块
+    => 提交一个小闭包时，稳定状态下不再产生堆分配，也没有 shared_ptr 引用计数开销
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template<typename Signature>
+class UniqueFunction;
+
+template<typename R, typename... Args>
+class UniqueFunction<R(Args...)> {
+public:
+    // 内联缓冲区大小：加上虚表指针后整个对象恰好占一个缓存行（64 字节）
+    static constexpr size_t kInlineSize = 7 * sizeof(void*);
+
+    UniqueFunction() noexcept : vtable_(nullptr) {}
+    UniqueFunction(std::nullptr_t) noexcept : vtable_(nullptr) {}
+
+    template<typename F, typename = std::enable_if_t<
+        !std::is_same<std::decay_t<F>, UniqueFunction>::value &&
+        std::is_invocable_r<R, std::decay_t<F>&, Args...>::value>>
+    UniqueFunction(F&& f) : vtable_(nullptr) {
+        using Fn = std::decay_t<F>;
+        if constexpr (fitsInline<Fn>()) {
+            ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(f));
+            vtable_ = &kInlineVTable<Fn>;
+        } else {
+            ::new (static_cast<void*>(storage_)) Fn*(new Fn(std::forward<F>(f)));
+            vtable_ = &kHeapVTable<Fn>;
+        }
+    }
+
+    UniqueFunction(UniqueFunction&& other) noexcept : vtable_(other.vtable_) {
+        if (vtable_) {
+            vtable_->move(storage_, other.storage_);
+            other.vtable_ = nullptr;
+        }
+    }
+
+    UniqueFunction& operator=(UniqueFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            if (other.vtable_) {
+                other.vtable_->move(storage_, other.storage_);
+                vtable_ = other.vtable_;
+                other.vtable_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    UniqueFunction(const UniqueFunction&) = delete;
+    UniqueFunction& operator=(const UniqueFunction&) = delete;
+
+    ~UniqueFunction() { reset(); }
+
+    explicit operator bool() const noexcept { return vtable_ != nullptr; }
+
+    R operator()(Args... args) {
+        return vtable_->invoke(storage_, std::forward<Args>(args)...);
+    }
+
+    void reset() noexcept {
+        if (vtable_) {
+            vtable_->destroy(storage_);
+            vtable_ = nullptr;
+        }
+    }
+
+    // 可调用对象是否会放在内联缓冲区中（用于测试和基准）
+    template<typename F>
+    static constexpr bool fitsInline() {
+        return sizeof(F) <= kInlineSize && alignof(F) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible<F>::value;
+    }
+
+private:
+    struct VTable {
+        R (*invoke)(void* storage, Args&&... args);
+        void (*move)(void* dst, void* src) noexcept;   // 移动构造到 dst 并销毁 src
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template<typename Fn>
+    static constexpr VTable kInlineVTable = {
+        [](void* s, Args&&... args) -> R {
+            return std::invoke(*static_cast<Fn*>(s), std::forward<Args>(args)...);
+        },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* s) noexcept { static_cast<Fn*>(s)->~Fn(); }
+    };
+
+    template<typename Fn>
+    static constexpr VTable kHeapVTable = {
+        [](void* s, Args&&... args) -> R {
+            return std::invoke(**static_cast<Fn**>(s), std::forward<Args>(args)...);
+        },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Fn*(*static_cast<Fn**>(src));
+        },
+        [](void* s) noexcept { delete *static_cast<Fn**>(s); }
+    };
+
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    const VTable* vtable_;
+};
+
+// 按大小分级的内存块缓存（类似 tcmalloc 的线程缓存 + 中央仓库）：
+// - 每个线程有自己的空闲链表，分配/释放都不加锁
+// - promise 的共享状态经常在提交线程分配、在工作线程释放，链表过长时整批（kBatch 个）归还中央仓库，
+//   链表为空时再整批取回，加锁次数摊薄到每 kBatch 个块一次
+class TaskMemoryPool {
+public:
+    static void* allocate(size_t bytes) {
+        int cls = sizeClass(bytes);
+        if (cls < 0) return ::operator new(bytes);
+        Cache* cache = local();
+        if (!cache) return ::operator new(kClassSize[cls]);
+        FreeList& list = cache->lists[cls];
+        if (!list.head) refill(cls, list);
+        if (list.head) {
+            Block* block = list.head;
+            list.head = block->next;
+            --list.count;
+            return block;
+        }
+        return ::operator new(kClassSize[cls]);
+    }
+
+    static void deallocate(void* p, size_t bytes) noexcept {
+        int cls = sizeClass(bytes);
+        Cache* cache = cls < 0 ? nullptr : local();
+        if (!cache) {
+            ::operator delete(p);
+            return;
+        }
+        FreeList& list = cache->lists[cls];
+        Block* block = static_cast<Block*>(p);
+        block->next = list.head;
+        list.head = block;
+        if (++list.count >= 2 * kBatch) release(cls, list);
+    }
+
+private:
+    struct Block { Block* next; };
+    struct FreeList { Block* head = nullptr; size_t count = 0; };
+
+    static constexpr size_t kClassSize[] = {64, 128, 256, 512};
+    static constexpr int kNumClasses = 4;
+    static constexpr size_t kBatch = 64;              // 线程缓存与中央仓库之间一次转移的块数
+    static constexpr size_t kMaxDepotBatches = 1024;  // 中央仓库每个大小级别最多保留的批数
+
+    struct Depot {
+        std::mutex mtx;
+        std::vector<Block*> batches[kNumClasses];     // 每个元素是一条长度为 kBatch 的链表
+        Depot() {
+            for (auto& b : batches) b.reserve(kMaxDepotBatches);   // 一次性预留，之后 push_back 不会再分配
+        }
+    };
+
+    struct Cache {
+        FreeList lists[kNumClasses];
+        ~Cache() {
+            for (auto& list : lists) {
+                freeChain(list.head);
+                list.head = nullptr;
+                list.count = 0;
+            }
+            cacheDestroyed() = true;
+        }
+    };
+
+    static Depot& depot() {
+        static Depot* instance = new Depot;   // 故意不析构：线程退出时的 Cache 析构可能晚于静态对象析构
+        return *instance;
+    }
+
+    // 线程退出时，析构顺序在 Cache 之后的 thread_local 仍可能分配 / 释放（如持有 Future 的对象）；
+    // Cache 析构后返回 nullptr，这些调用直接走 ::operator new / delete
+    static Cache* local() {
+        if (cacheDestroyed()) return nullptr;
+        static thread_local Cache cache;
+        return &cache;
+    }
+
+    static bool& cacheDestroyed() {
+        static thread_local bool destroyed = false;     // 平凡类型，线程退出时不会被析构
+        return destroyed;
+    }
+
+    static int sizeClass(size_t bytes) {
+        for (int i = 0; i < kNumClasses; ++i) {
+            if (bytes <= kClassSize[i]) return i;
+        }
+        return -1;
+    }
+
+    static void freeChain(Block* head) noexcept {
+        while (head) {
+            Block* next = head->next;
+            ::operator delete(head);
+            head = next;
+        }
+    }
+
+    static void refill(int cls, FreeList& list) {
+        Depot& d = depot();
+        std::lock_guard<std::mutex> lock(d.mtx);
+        if (d.batches[cls].empty()) return;
+        list.head = d.batches[cls].back();
+        list.count = kBatch;
+        d.batches[cls].pop_back();
+    }
+
+    // 从链表头部摘下 kBatch 个块交给中央仓库
+    static void release(int cls, FreeList& list) noexcept {
+        Block* batch = list.head;
+        Block* tail = batch;
+        for (size_t i = 1; i < kBatch; ++i) tail = tail->next;
+        list.head = tail->next;
+        list.count -= kBatch;
+        tail->next = nullptr;
+
+        Depot& d = depot();
+        {
+            std::lock_guard<std::mutex> lock(d.mtx);
+            if (d.batches[cls].size() < kMaxDepotBatches) {
+                d.batches[cls].push_back(batch);
+                return;
+            }
+        }
+        freeChain(batch);
+    }
+};
+
+template<typename T>
+struct RecyclingAllocator {
+    using value_type = T;
+
+    RecyclingAllocator() noexcept = default;
+    template<typename U>
+    RecyclingAllocator(const RecyclingAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported");
+        return static_cast<T*>(TaskMemoryPool::allocate(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) noexcept {
+        TaskMemoryPool::deallocate(p, n * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const RecyclingAllocator<U>&) const noexcept { return true; }
+    template<typename U>
+    bool operator!=(const RecyclingAllocator<U>&) const noexcept { return false; }
+};
+
+// 绑定可调用对象及其参数（代替 std::bind）：参数按值保存，调用时移动传入
+template<typename F, typename... Args>
+class BoundCall {
+public:
+    template<typename G, typename... A>
+    explicit BoundCall(G&& f, A&&... args)
+        : fn_(std::forward<G>(f)), args_(std::forward<A>(args)...) {}
+
+    decltype(auto) operator()() {
+        return std::apply(std::move(fn_), std::move(args_));
+    }
+
+private:
+    F fn_;
+    std::tuple<Args...> args_;
+};
+
+// 无参数时直接保存可调用对象，省去空 tuple 的填充字节
+template<typename F>
+class BoundCall<F> {
+public:
+    template<typename G>
+    explicit BoundCall(G&& f) : fn_(std::forward<G>(f)) {}
+
+    decltype(auto) operator()() { return std::invoke(std::move(fn_)); }
+
+private:
+    F fn_;
+};
+
+// 可调用对象与 promise 融合在一起：执行时把返回值或异常写入 promise；
+// 若任务未执行就被销毁，promise 析构会让 future 得到 broken_promise
+template<typename R, typename F>
+class PromiseTask {
+public:
+    PromiseTask(F&& fn, std::promise<R>&& promise)
+        : fn_(std::move(fn)), promise_(std::move(promise)) {}
+
+    void operator()() {
+        try {
+            if constexpr (std::is_void<R>::value) {
+                fn_();
+                promise_.set_value();
+            } else {
+                promise_.set_value(fn_());
+            }
+        } catch (...) {
+            promise_.set_exception(std::current_exception());
+        }
+    }
+
+private:
+    F fn_;
+    std::promise<R> promise_;
+};
+
+// 构造一个融合任务，返回 {任务, future}；共享状态由 RecyclingAllocator 分配
+template<typename F, typename... Args>
+auto makePromiseTask(F&& f, Args&&... args) {
+    using Fn = BoundCall<std::decay_t<F>, std::decay_t<Args>...>;
+    using ReturnType = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+
+    std::promise<ReturnType> promise(std::allocator_arg, RecyclingAllocator<char>());
+    std::future<ReturnType> future = promise.get_future();
+    PromiseTask<ReturnType, Fn> task(Fn(std::forward<F>(f), std::forward<Args>(args)...), std::move(promise));
+    return std::make_pair(std::move(task), std::move(future));
+}
+
+#endif // TASK_H
@@ -0,0 +1,255 @@
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+/*
+ **************** 任务依赖图（DAG） ****************
+ 参考：阅读感悟/airflow.md 中 DAG / set_upstream / set_downstream / ">>" 的写法
+ 设计目标：
+    1. 先声明任务和依赖（a >> b >> c、a >> {b, c}），再整体运行，返回一个 Future<void>
+    2. 每个节点记录未完成的上游个数，上游完成时递减，减到 0 才提交到线程池：没有线程阻塞等待依赖
+    3. 运行前用拓扑排序检查是否有环，有环时抛出异常
+    4. 某个任务失败时，其所有下游被标记为 UpstreamFailed 并跳过（与 Airflow 的 upstream_failed 一致），
+       与失败任务无关的分支继续执行；全部结束后 Future 以第一个异常失败
+    5. 同一个图可以重复运行，但同一时刻只能有一次运行
+*/
+
+#include "Future.h"
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class TaskGraph {
+public:
+    using Task = UniqueFunction<void()>;
+
+    enum class State {
+        Pending,
+        Running,
+        Success,
+        Failed,
+        UpstreamFailed      // 上游失败，本任务未执行
+    };
+
+    // 节点句柄：用于声明依赖
+    class Node {
+    public:
+        Node() = default;
+
+        // this 完成后才运行 downstream（Airflow 的 set_downstream / ">>"）
+        Node& set_downstream(Node downstream) {
+            graph_->addEdge(index_, downstream.index_);
+            return *this;
+        }
+
+        Node& set_upstream(Node upstream) {
+            graph_->addEdge(upstream.index_, index_);
+            return *this;
+        }
+
+        // a >> b：返回 b，便于写 a >> b >> c
+        Node operator>>(Node downstream) {
+            set_downstream(downstream);
+            return downstream;
+        }
+
+        // a >> {b, c}：返回 a
+        Node operator>>(std::initializer_list<Node> downstreams) {
+            for (Node node : downstreams) set_downstream(node);
+            return *this;
+        }
+
+        const std::string& name() const { return graph_->nodes_[index_].name; }
+        State state() const { return graph_->nodes_[index_].state.load(); }
+
+    private:
+        friend class TaskGraph;
+        Node(TaskGraph* graph, size_t index) : graph_(graph), index_(index) {}
+
+        TaskGraph* graph_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    explicit TaskGraph(Executor executor) : executor_(executor), running_(false) {}
+
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    // 添加任务；task 可以多次运行（每次 run 调用一次），因此保存为可重复调用的对象
+    template<typename F>
+    Node add(std::string name, F&& task) {
+        checkIdle();
+        nodes_.emplace_back(std::move(name), Task(std::forward<F>(task)));
+        return Node(this, nodes_.size() - 1);
+    }
+
+    size_t size() const { return nodes_.size(); }
+
+    // 运行整个图；所有任务结束（成功、失败或被跳过）后 Future 就绪；图对象必须存活到 Future 就绪
+    Future<void> run() {
+        if (running_.exchange(true)) throw std::runtime_error("TaskGraph is already running");
+        try {
+            checkAcyclic();
+        } catch (...) {
+            running_.store(false);
+            throw;
+        }
+
+        auto run = std::make_shared<RunState>(executor_);
+        Future<void> done = run->promise.get_future();
+        run->remaining.store(nodes_.size());
+        for (auto& node : nodes_) {
+            node.pendingUpstreams.store(node.upstreamCount);
+            node.upstreamFailed.store(false);
+            node.state.store(State::Pending);
+        }
+        if (nodes_.empty()) {
+            finish(run);
+            return done;
+        }
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            if (nodes_[i].upstreamCount == 0) schedule(run, i);
+        }
+        return done;
+    }
+
+private:
+    struct NodeData {
+        NodeData(std::string n, Task t) : name(std::move(n)), task(std::move(t)) {}
+        NodeData(NodeData&& other) noexcept
+            : name(std::move(other.name)), task(std::move(other.task)),
+              downstreams(std::move(other.downstreams)), upstreamCount(other.upstreamCount) {}
+
+        std::string name;
+        Task task;
+        std::vector<size_t> downstreams;
+        size_t upstreamCount = 0;
+        std::atomic<size_t> pendingUpstreams{0};    // 本次运行中尚未结束的上游个数
+        std::atomic<bool> upstreamFailed{false};
+        std::atomic<State> state{State::Pending};
+    };
+
+    // 一次运行的共享状态：剩余节点数 + 第一个异常
+    struct RunState {
+        explicit RunState(Executor executor) : promise(executor) {}
+
+        std::atomic<size_t> remaining{0};
+        std::mutex errorMtx;
+        std::exception_ptr error;
+        Promise<void> promise;
+    };
+
+    void checkIdle() const {
+        if (running_.load()) throw std::runtime_error("TaskGraph cannot be modified while running");
+    }
+
+    void addEdge(size_t from, size_t to) {
+        checkIdle();
+        if (from == to) throw std::invalid_argument("TaskGraph task cannot depend on itself");
+        nodes_[from].downstreams.push_back(to);
+        ++nodes_[to].upstreamCount;
+    }
+
+    // Kahn 拓扑排序：能排完所有节点说明无环
+    void checkAcyclic() const {
+        std::vector<size_t> indegree(nodes_.size());
+        std::queue<size_t> ready;
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            indegree[i] = nodes_[i].upstreamCount;
+            if (indegree[i] == 0) ready.push(i);
+        }
+        size_t visited = 0;
+        while (!ready.empty()) {
+            size_t i = ready.front();
+            ready.pop();
+            ++visited;
+            for (size_t next : nodes_[i].downstreams) {
+                if (--indegree[next] == 0) ready.push(next);
+            }
+        }
+        if (visited != nodes_.size()) throw std::runtime_error("TaskGraph contains a cycle");
+    }
+
+    void schedule(const std::shared_ptr<RunState>& run, size_t index) {
+        try {
+            executor_([this, run, index] { execute(run, index); });
+        } catch (...) {
+            // 没有执行器时任务就地运行，它已经开始后抛出的异常不属于提交失败
+            if (nodes_[index].state.load() != State::Pending) throw;
+            // 提交失败（如线程池已停止）：该节点按失败处理，下游随之跳过，保证 run() 的 Future 最终就绪
+            nodes_[index].state.store(State::Failed);
+            recordError(*run, std::current_exception());
+            settle(run, index, true);
+        }
+    }
+
+    void execute(const std::shared_ptr<RunState>& run, size_t index) {
+        NodeData& node = nodes_[index];
+        bool failed = false;
+        if (node.upstreamFailed.load()) {
+            node.state.store(State::UpstreamFailed);
+            failed = true;
+        } else {
+            node.state.store(State::Running);
+            try {
+                node.task();
+                node.state.store(State::Success);
+            } catch (...) {
+                node.state.store(State::Failed);
+                recordError(*run, std::current_exception());
+                failed = true;
+            }
+        }
+        settle(run, index, failed);
+    }
+
+    // 节点结束后通知下游。上游失败的下游不需要占用线程池，直接标记为 UpstreamFailed 并继续向下传播；
+    // 用显式的工作表代替递归，长链上的失败传播不会耗尽栈
+    void settle(const std::shared_ptr<RunState>& run, size_t index, bool failed) {
+        std::vector<size_t> skipped;
+        while (true) {
+            for (size_t next : nodes_[index].downstreams) {
+                if (failed) nodes_[next].upstreamFailed.store(true);
+                if (nodes_[next].pendingUpstreams.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    if (nodes_[next].upstreamFailed.load()) {
+                        skipped.push_back(next);
+                    } else {
+                        schedule(run, next);
+                    }
+                }
+            }
+            if (run->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) finish(run);
+            if (skipped.empty()) return;
+            index = skipped.back();
+            skipped.pop_back();
+            nodes_[index].state.store(State::UpstreamFailed);
+            failed = true;
+        }
+    }
+
+    static void recordError(RunState& run, std::exception_ptr error) {
+        std::lock_guard<std::mutex> lock(run.errorMtx);
+        if (!run.error) run.error = error;
+    }
+
+    void finish(const std::shared_ptr<RunState>& run) {
+        running_.store(false);
+        if (run->error) {
+            run->promise.set_exception(run->error);
+        } else {
+            run->promise.set_value();
+        }
+    }
+
+    Executor executor_;
+    std::vector<NodeData> nodes_;
+    std::atomic<bool> running_;
+};
+
+#endif // TASK_GRAPH_H
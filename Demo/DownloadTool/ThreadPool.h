@@ -5,11 +5,51 @@
  **************** 线程池 ****************
  设计目标：
     1. 支持异步任务提交和结果获取
-    2. 管理固定数量的工作线程，复用线程以减少创建/销毁开销
-    3. 线程安全，支持并发访问任务队列
+    2. 复用工作线程以减少创建/销毁开销；核心/最大线程数弹性伸缩：
+       排队过深或任务等待过久时临时扩容，非核心线程空闲超过 keepAlive 后回收
+    3. 线程安全：任务队列为有界无锁 MPMC 环形队列，互斥锁只用于空闲线程的休眠/唤醒
     4. 优雅停止，析构时清理所有线程
+    5. 任务为只可移动的 UniqueFunction，小闭包与 promise 融合后内联存放，提交时不分配堆内存
+    6. 批量提交：一批任务入队后只唤醒 min(任务数, 空闲线程数) 个线程
+    7. 队列满时按拒绝策略处理（阻塞 / 抛异常 / 调用者执行 / 丢弃最旧任务），try_enqueue 支持超时
+    8. 多条任务通道：High / Normal / Low 三个优先级 + 按截止时间排序（EDF）的通道；
+       工作线程按加权轮询取任务，低优先级也能得到份额，即将到期的截止时间任务优先执行；
+       每条通道单独统计排队等待时间分布
+    9. 延迟 / 周期任务：schedule_after / schedule_every 由分层时间轮管理，单个定时线程在到期时把任务
+       批量放入任务队列，不占用工作线程休眠等待；队列满时定时线程等待空位，不受拒绝策略影响
+   10. async 返回可组合的 Future（then / when_all / when_any），后续任务在上游完成时才入队，不阻塞工作线程
+   11. C++20 下支持协程：co_await pool.schedule() 切换到工作线程，co_await pool.sleep_for(d) 由时间轮恢复
+       （CoTask / sync_wait 等见 Coroutine.h）
+   12. 可按 CPU 列表或检测到的拓扑绑核（见 ../ThreadPool/Topology.h），工作线程槽位 i 固定使用第 i 个 CPU
+   13. 运行指标：每个工作线程各自记录（单写者计数器 + 对数-线性直方图，热路径上没有共享原子操作）
+       排队等待、执行耗时、出队时的队列深度、空闲时长、空轮询次数、mtx_ 竞争；stats() 汇总快照，
+       定期写入日志见 PoolMetrics.h
+   14. 空闲线程先自旋（pause）、再让出 CPU（yield），最后在各自的 Parker（futex）上休眠；
+       提交任务时只有没有线程在自旋才唤醒一个休眠线程，被唤醒的线程先计入自旋者，避免连续提交时重复唤醒；
+       自旋者取到任务时若它是最后一个自旋者且队列仍非空，再接力唤醒一个，保证积压的任务有人处理
+   15. 工作线程内部提交的普通任务（递归拆分、后续任务、协程恢复）不经过全局通道：
+       放入该线程的"下一个任务"槽位，槽位中原有的任务移入它的 Chase-Lev 本地队列（../ThreadPool/WorkStealingDeque.h）；
+       本线程优先执行槽位（LIFO，缓存仍热），其他线程只能从本地队列顶部窃取，
+       快要休眠的线程才会拿走别人槽位中的任务（任务在父任务里被同步等待时也不会卡死）；
+       每 61 个任务先看一次全局通道，连续执行槽位任务不超过 3 次，外部提交不会被饿死。
+       本地队列无界，不受 queueCapacity 和拒绝策略约束；外部线程提交仍走全局通道
+   16. 协作式取消（StopToken.h）：enqueue / async / post 可带 StopToken，开始执行前已取消的任务不运行，
+       future 得到 TaskCancelledError；可调用对象若接受 StopToken 作为第一个参数，则把 token 传给它，
+       运行中的任务据此轮询 stop_requested() 提前返回
+   17. 边等边干：wait(future) / get(future) / help_until(pred) 在等待期间执行其他排队任务；
+       工作线程先执行自己本地队列中的任务（通常就是刚拆出的子任务），再从其他线程窃取，
+       因此在任务内部等待同一线程池的任务不会占死工作线程，任意深度的 fork-join 都不会自锁
 */
 
+#include "Task.h"
+#include "BoundedQueue.h"
+#include "Histogram.h"
+#include "TimerWheel.h"
+#include "Future.h"
+#include "Parker.h"
+#include "StopToken.h"
+#include "../ThreadPool/Topology.h"
+#include "../ThreadPool/WorkStealingDeque.h"
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -17,68 +57,1283 @@
 #include <functional>
 #include <stdexcept>
 #include <vector>
-#include <queue>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <iterator>
+#include <exception>
+#include <chrono>
+#include <optional>
+#include <array>
+#include <tuple>
+#include <type_traits>
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
+
+// 队列已满且拒绝策略为 FailFast 时抛出
+class QueueFullError : public std::runtime_error {
+public:
+    QueueFullError() : std::runtime_error("Thread pool queue is full") {}
+};
+
+// 带取消令牌的调用：执行前检查令牌；可调用对象接受 StopToken 作为第一个参数时把令牌传给它
+template<typename F, typename... Args>
+class CancellableCall {
+    static constexpr bool kTakesToken = std::is_invocable<F, StopToken, Args...>::value;
+
+public:
+    using ResultType = typename std::conditional_t<kTakesToken, std::invoke_result<F, StopToken, Args...>,
+                                                   std::invoke_result<F, Args...>>::type;
+
+    template<typename G, typename... A>
+    CancellableCall(StopToken token, G&& f, A&&... args)
+        : token_(std::move(token)), fn_(std::forward<G>(f)), args_(std::forward<A>(args)...) {}
+
+    ResultType operator()() {
+        if (token_.stop_requested()) throw TaskCancelledError();
+        if constexpr (kTakesToken) {
+            return std::apply([this](auto&&... args) -> ResultType {
+                return std::invoke(std::move(fn_), token_, std::forward<decltype(args)>(args)...);
+            }, std::move(args_));
+        } else {
+            return std::apply(std::move(fn_), std::move(args_));
+        }
+    }
+
+private:
+    StopToken token_;
+    F fn_;
+    std::tuple<Args...> args_;
+};
+
+template<typename F, typename... Args>
+using CancellableResult = typename CancellableCall<std::decay_t<F>, std::decay_t<Args>...>::ResultType;
 
 class ThreadPool {
 public:
-    ThreadPool(size_t numThreads) : stop_(false) {
-        // 初始化固定个数的工作线程，循环等待任务
-        for (int i = 0; i < numThreads; ++i) {
-            workers_.emplace_back([this] {  // 原地构造工作线程
-                while (true) {
-                    std::function<void()> task; // 任务无参数、无返回
-                    {
-                        std::unique_lock<std::mutex> lock(mtx_);
-                        cv_.wait(lock, [this] {return stop_ || !tasks_.empty(); });
-                        if (stop_ && tasks_.empty()) return; // 无任务时停止工作线程
-                        task = std::move(tasks_.front());
-                        tasks_.pop();
-                    }
-                    task(); // 释放锁执行任务（有可能任务较为耗时）
-                }
-            });
+    using Task = UniqueFunction<void()>;    // 任务无参数、无返回，只可移动
+    using Clock = std::chrono::steady_clock;
+
+    // 队列满时的拒绝策略
+    enum class RejectPolicy {
+        Block,          // 阻塞提交线程直到有空位（工作线程内部提交时改为就地执行，避免自锁）
+        FailFast,       // 抛出 QueueFullError
+        CallerRuns,     // 在提交线程上直接执行任务
+        DropOldest      // 丢弃队首（最旧）任务，其 future 得到 broken_promise
+    };
+
+    // 优先级通道
+    enum class Priority {
+        High,           // 延迟敏感的小任务（进度、界面通知）
+        Normal,         // 默认
+        Low             // 后台批量任务
+    };
+
+    static constexpr size_t kPriorityLanes = 3;
+    static constexpr size_t kDeadlineLane = 3;          // 截止时间通道的编号
+    static constexpr size_t kLaneCount = 4;
+
+    // 线程数量与任务队列参数
+    struct Options {
+        size_t coreThreads = 4;                                  // 核心线程数（常驻）
+        size_t maxThreads = 4;                                   // 最大线程数（高负载时的上限）
+        std::chrono::milliseconds keepAlive{60000};              // 非核心线程的最长空闲时间
+        size_t growQueueDepth = 16;                              // 无空闲线程且排队任务数达到该值时扩容
+        std::chrono::milliseconds growQueueLatency{50};          // 无空闲线程且任务等待超过该时长时扩容
+        size_t queueCapacity = 4096;                             // 任务队列容量（向上取 2 的幂）
+        RejectPolicy rejectPolicy = RejectPolicy::Block;         // 队列满时的处理方式
+        std::array<size_t, kLaneCount> laneWeights{{8, 4, 1, 8}}; // 加权轮询权重：High / Normal / Low / Deadline
+        std::chrono::milliseconds deadlineUrgency{5};            // 截止时间在此范围内的任务跳过轮询立即执行
+        std::chrono::milliseconds timerTick{1};                  // 时间轮刻度（定时任务的精度）
+        CpuAffinity affinity;                                    // 绑核方式，默认不绑核
+        size_t idleSpins = 64;                                   // 休眠前的自旋轮数（每轮取一次任务 + 若干 pause）
+        size_t idleYields = 4;                                   // 自旋后、休眠前让出 CPU 的轮数；两者为 0 时直接休眠
+    };
+
+    // 伸缩计数器快照
+    struct SizingStats {
+        size_t liveThreads;     // 当前存活线程数
+        size_t idleThreads;     // 当前空闲线程数（自旋中 + 休眠中）
+        size_t peakThreads;     // 历史最大线程数
+        uint64_t grown;         // 扩容（创建非核心线程）次数
+        uint64_t retired;       // 回收空闲线程次数
+    };
+
+    // 任务队列计数器快照
+    struct QueueStats {
+        size_t capacity;        // 队列容量
+        size_t depth;           // 当前排队任务数（近似）
+        uint64_t rejected;      // FailFast 拒绝 / try_enqueue 超时次数
+        uint64_t callerRuns;    // 在提交线程上执行的次数
+        uint64_t dropped;       // DropOldest 丢弃的任务数
+    };
+
+    // 单条通道的统计快照（每条通道的容量均为 queueCapacity）
+    struct LaneStats {
+        size_t depth;               // 当前排队任务数（近似）
+        uint64_t executed;          // 已开始执行的任务数
+        uint64_t deadlineMisses;    // 开始执行时已超过截止时间的任务数（仅截止时间通道）
+        HistogramSnapshot waitNs;   // 入队到开始执行的等待时间分布（纳秒），可取 percentile(0.5/0.99)
+    };
+
+    // 单个工作线程（或汇总）的运行指标快照
+    struct WorkerStats {
+        bool active = false;            // 该槽位当前是否有存活线程
+        int cpu = -1;
+        uint64_t executed = 0;          // 已执行的任务数
+        uint64_t idleNs = 0;            // 等待任务（休眠）的累计时长
+        uint64_t emptyPolls = 0;        // 去队列取任务但一无所获的次数
+        uint64_t spinHits = 0;          // 在自旋 / 让出阶段取到任务的次数（省去一次休眠和唤醒）
+        uint64_t parks = 0;             // 在 Parker 上休眠的次数
+        uint64_t localPushes = 0;       // 在本线程内提交、进入本地槽位 / 本地队列的任务数
+        uint64_t lifoHits = 0;          // 从"下一个任务"槽位取到的任务数
+        uint64_t steals = 0;            // 从其他线程的本地队列 / 槽位窃取的任务数
+        uint64_t lockContended = 0;     // 获取 mtx_ 时需要等待的次数
+        uint64_t lockWaitNs = 0;        // 等待 mtx_ 的累计时长
+        HistogramSnapshot waitNs;       // 入队到开始执行（纳秒）
+        HistogramSnapshot runNs;        // 执行耗时（纳秒）
+        HistogramSnapshot queueDepth;   // 每次取到任务后队列中剩余的任务数
+    };
+
+    // 线程池运行指标快照
+    struct Stats {
+        std::vector<WorkerStats> workers;   // 按槽位排列
+        WorkerStats total;                  // 所有工作线程之和（另含 run_pending_task 在外部线程执行的任务）
+        size_t queueDepth = 0;              // 当前排队任务数
+        size_t liveThreads = 0;
+        size_t idleThreads = 0;
+        size_t spinningThreads = 0;         // 其中正在自旋找任务的线程数
+        size_t parkedThreads = 0;           // 其中在 Parker 上休眠的线程数
+        uint64_t producerLockContended = 0; // 提交方（非工作线程）获取 mtx_ 时需要等待的次数
+        uint64_t taskExceptions = 0;        // post() 的任务抛出、被拦下的异常数
+    };
+
+    // 固定线程数：核心线程数 = 最大线程数 = numThreads
+    ThreadPool(size_t numThreads) : ThreadPool(fixedSize(numThreads)) {}
+
+    explicit ThreadPool(const Options& options)
+        : options_(options), slots_(std::max(options.maxThreads, options.coreThreads)),
+          deadlineCount_(0), liveThreads_(0), idle_(0), blockedProducers_(0),
+          peakThreads_(0), grown_(0), retired_(0), rejected_(0), callerRuns_(0), dropped_(0), stop_(false),
+          timers_(options.timerTick, [this](std::vector<Task>& batch) { pushTimerBatch(batch); }) {
+        options_.maxThreads = slots_.size();
+        if (options_.maxThreads == 0) throw std::invalid_argument("ThreadPool needs at least one worker");
+        std::vector<int> cpus = options_.affinity.resolve(slots_.size());
+        for (size_t i = 0; i < slots_.size(); ++i) slots_[i].cpu = cpus[i];
+        for (auto& lane : lanes_) {
+            lane.reset(new BoundedQueue<QueuedTask>(options_.queueCapacity));
+        }
+        deadlineHeap_.reserve(std::min<size_t>(options_.queueCapacity, 1024));
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (size_t i = 0; i < options_.coreThreads; ++i) {
+            spawnWorkerLocked();
         }
     }
 
     ~ThreadPool() {
+        timers_.stop();     // 先停止定时线程：未到期的定时任务被丢弃，不再向队列投递
+        std::vector<size_t> parked;
         {
             std::lock_guard<std::mutex> lock(mtx_);
-            stop_ = true;   // 需要加锁以保护任务队列
+            stop_ = true;   // 加锁设置，保证正在进入休眠的线程能看到；之后不会再创建新线程
+            parked = takeParkedLocked(parked_.size());
+        }
+        for (size_t index : parked) slots_[index].parker.unpark();
+        {
+            std::lock_guard<std::mutex> lock(spaceMtx_);
         }
-        cv_.notify_all();
-        for (auto& worker : workers_) {
-            if (worker.joinable()) {
-                worker.join();
+        spaceCv_.notify_all();
+        for (auto& slot : slots_) {
+            if (slot.thread.joinable()) {
+                slot.thread.join();
             }
         }
+        // 工作线程退出前已取空本地任务；这里只做兜底释放
+        for (auto& slot : slots_) {
+            QueuedTask item;
+            QueuedTask* task = slot.next.exchange(nullptr);
+            if (task) takeLocalTask(task, item);
+            while (slot.local.pop(task)) takeLocalTask(task, item);
+        }
     }
 
     // 异步提交任务，返回 std::future 以获取结果
     template<typename F, typename... Args>  // 可变参数模板（接受多个类型参数）
-    auto enqueue(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
-        // 推断可调用对象的返回类型
-        using ReturnType = std::invoke_result_t<F, Args...>;
-        // 将一个零参数的可调用对象封装为异步任务
-        auto task = std::make_shared<std::packaged_task<ReturnType()>>(
-            std::bind(std::forward<F>(f), std::forward<Args>(args)...) // 完美转发 f 和参数 args...
-        );
-        std::future<ReturnType> result = task->get_future(); // 异步任务的结果容器
+    auto enqueue(F&& f, Args&&... args) -> std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>> {
+        // 可调用对象、参数与 promise 融合为一个任务对象（完美转发 f 和参数 args...）
+        auto [task, result] = makePromiseTask(std::forward<F>(f), std::forward<Args>(args)...);
+        pushTask(Task(std::move(task)), laneOf(Priority::Normal));
+        return std::move(result);
+    }
+
+    // 按优先级提交
+    template<typename F, typename... Args>
+    auto enqueue(Priority priority, F&& f, Args&&... args)
+        -> std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>> {
+        auto [task, result] = makePromiseTask(std::forward<F>(f), std::forward<Args>(args)...);
+        pushTask(Task(std::move(task)), laneOf(priority));
+        return std::move(result);
+    }
+
+    // 按绝对截止时间提交：截止时间通道内按最早截止时间优先（EDF）执行
+    template<typename F, typename... Args>
+    auto enqueue(Clock::time_point deadline, F&& f, Args&&... args)
+        -> std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>> {
+        auto [task, result] = makePromiseTask(std::forward<F>(f), std::forward<Args>(args)...);
+        pushTask(Task(std::move(task)), kDeadlineLane, deadline);
+        return std::move(result);
+    }
+
+    // 可取消的提交：开始执行前 token 已取消则不运行，future 得到 TaskCancelledError
+    template<typename F, typename... Args>
+    auto enqueue(StopToken token, F&& f, Args&&... args) -> std::future<CancellableResult<F, Args...>> {
+        auto [task, result] = makePromiseTask(CancellableCall<std::decay_t<F>, std::decay_t<Args>...>(
+            std::move(token), std::forward<F>(f), std::forward<Args>(args)...));
+        pushTask(Task(std::move(task)), laneOf(Priority::Normal));
+        return std::move(result);
+    }
+
+    // 限时提交：队列满时最多等待 timeout，仍无空位则放弃并返回 std::nullopt（不受拒绝策略影响）
+    template<typename Rep, typename Period, typename F, typename... Args>
+    auto try_enqueue(std::chrono::duration<Rep, Period> timeout, F&& f, Args&&... args)
+        -> std::optional<std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>>> {
+        auto [task, result] = makePromiseTask(std::forward<F>(f), std::forward<Args>(args)...);
+        if (stop_.load()) throw std::runtime_error("Enqueue on stopped thread pool");
+        auto now = Clock::now();
+        QueuedTask item{Task(std::move(task)), now};
+        size_t lane = laneOf(Priority::Normal);
+        if (!tryPushLane(lane, item) &&
+            !waitUntilPushed(lane, item, now + std::chrono::duration_cast<Clock::duration>(timeout))) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+        afterPush(1);
+        return std::move(result);
+    }
+
+    // 提交不需要结果的任务（不创建 promise/future）；任务抛出的异常被丢弃，只计入 Stats::taskExceptions
+    template<typename F>
+    void post(F&& f) {
+        pushTask(Task(std::forward<F>(f)), laneOf(Priority::Normal));
+    }
+
+    // 提交到全局 Normal 通道末尾：在工作线程内调用也不进入本线程的本地槽位 / 本地队列，
+    // 排在其他线程已提交的任务之后。用于主动让出工作线程的续作（如 Strand 排空一轮后重新提交自己）；
+    // 全局通道已满时退回本地队列，不按拒绝策略让调用方就地执行（避免续作递归）
+    template<typename F>
+    void post_global(F&& f) {
+        Task task(std::forward<F>(f));
+        if (!inWorkerThread()) {
+            pushTask(std::move(task), laneOf(Priority::Normal));
+            return;
+        }
+        if (stop_.load()) throw std::runtime_error("Enqueue on stopped thread pool");
+        QueuedTask item{std::move(task), Clock::now()};
+        if (tryPushLane(laneOf(Priority::Normal), item)) {
+            afterPush(1);
+        } else {
+            pushLocal(std::move(item.task));
+        }
+    }
+
+    // 可取消的 post：开始执行前 token 已取消则直接丢弃
+    template<typename F>
+    void post(StopToken token, F&& f) {
+        pushTask(Task([token = std::move(token), fn = std::decay_t<F>(std::forward<F>(f))]() mutable {
+                     if (!token.stop_requested()) fn();
+                 }),
+                 laneOf(Priority::Normal));
+    }
+
+    // 在调用线程上执行一个排队中的任务，队列为空时返回 false；
+    // 等待其他任务完成的线程可以借此"边等边干"，而不是阻塞在 future 上
+    bool run_pending_task() {
+        QueuedTask item;
+        LaneCursor cursor;
+        size_t lane;
+        if (popAny(cursor, item, lane)) {
+            afterPop();
+        } else {
+            static thread_local uint64_t rng = 0x9E3779B97F4A7C15ull;
+            if (!stealTask(slots_.size(), rng, item, true)) return false;
+            lane = laneOf(Priority::Normal);
+        }
+        recordStart(externalStats_, lane, item, true);
+        runTask(item);
+        return true;
+    }
+
+    // 边等边干直到 done() 为真；没有可执行的任务时（被等待的任务正在别的线程上运行）先自旋再让出 CPU
+    template<typename Done>
+    void help_until(Done&& done) {
+        size_t idleRounds = 0;
+        while (!done()) {
+            if (helpOnce()) {
+                idleRounds = 0;
+            } else if (++idleRounds <= options_.idleSpins) {
+                for (int i = 0; i < 32; ++i) cpuRelax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // 等待 future 就绪，期间执行本线程池的其他任务；可以在工作线程内部安全调用
+    template<typename T>
+    void wait(const std::future<T>& future) {
+        if (!future.valid()) throw std::future_error(std::future_errc::no_state);
+        help_until([&future] { return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+    }
+
+    template<typename T>
+    void wait(const Future<T>& future) {
+        if (!future.valid()) throw std::future_error(std::future_errc::no_state);
+        help_until([&future] { return future.ready(); });
+    }
+
+    // wait 之后取出结果（或重新抛出异常）
+    template<typename T>
+    T get(std::future<T>& future) {
+        wait(future);
+        return future.get();
+    }
+
+    template<typename T>
+    T get(Future<T>& future) {
+        wait(future);
+        return future.get();
+    }
+
+    // 当前存活的工作线程数
+    size_t thread_count() const {
+        return liveThreads_.load(std::memory_order_relaxed);
+    }
+
+    SizingStats sizing_stats() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return {liveThreads_.load(), idle_.load(), peakThreads_, grown_, retired_};
+    }
+
+    QueueStats queue_stats() const {
+        return {options_.queueCapacity, queuedApprox(), rejected_.load(), callerRuns_.load(), dropped_.load()};
+    }
+
+    // 异步提交任务，返回可组合的 Future：then() 的后续任务默认也提交到本线程池
+    template<typename F, typename... Args>
+    auto async(F&& f, Args&&... args) -> Future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>> {
+        using ReturnType = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+        Promise<ReturnType> promise(executor());
+        Future<ReturnType> result = promise.get_future();
+        post([promise = std::move(promise), call = BoundCall<std::decay_t<F>, std::decay_t<Args>...>(
+                  std::forward<F>(f), std::forward<Args>(args)...)]() mutable {
+            promise.set_from(std::move(call));
+        });
+        return result;
+    }
+
+    // 可取消的 async：开始执行前 token 已取消则不运行，Future 以 TaskCancelledError 失败
+    template<typename F, typename... Args>
+    auto async(StopToken token, F&& f, Args&&... args) -> Future<CancellableResult<F, Args...>> {
+        using ReturnType = CancellableResult<F, Args...>;
+        Promise<ReturnType> promise(executor());
+        Future<ReturnType> result = promise.get_future();
+        post([promise = std::move(promise), call = CancellableCall<std::decay_t<F>, std::decay_t<Args>...>(
+                  std::move(token), std::forward<F>(f), std::forward<Args>(args)...)]() mutable {
+            promise.set_from(std::move(call));
+        });
+        return result;
+    }
+
+    // 把本线程池包装为 Future 使用的执行器
+    Executor executor() {
+        return Executor{this, [](void* pool, Task&& task) { static_cast<ThreadPool*>(pool)->post(std::move(task)); }};
+    }
+
+    // 延迟 delay 后执行 f（不返回 future；f 不应抛出异常），返回的句柄可用于取消
+    template<typename F>
+    TimerHandle schedule_after(Clock::duration delay, F&& f) {
+        return timers_.schedule_at(Clock::now() + delay, Task(std::forward<F>(f)));
+    }
+
+    // 每隔 period 执行一次 f，第一次在一个周期之后；f 上一次尚未执行完时跳过本次触发
+    template<typename F>
+    TimerHandle schedule_every(Clock::duration period, F&& f) {
+        return timers_.schedule_periodic(Clock::now() + period, period, Task(std::forward<F>(f)));
+    }
+
+    // 取消定时任务；返回 false 表示一次性任务已经触发（或句柄无效）
+    bool cancel_timer(TimerHandle handle) {
+        return timers_.cancel(handle);
+    }
+
+    // 尚未触发的定时任务数（周期任务一直计入）
+    size_t pending_timers() const {
+        return timers_.size();
+    }
+
+#if defined(__cpp_impl_coroutine)
+    // co_await pool.schedule()：挂起当前协程，由某个工作线程恢复执行
+    struct ScheduleAwaiter {
+        ThreadPool& pool;
+        Priority priority;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            pool.pushTask(Task([handle] { handle.resume(); }), laneOf(priority));
+        }
+        void await_resume() const noexcept {}
+    };
+
+    ScheduleAwaiter schedule(Priority priority = Priority::Normal) {
+        return ScheduleAwaiter{*this, priority};
+    }
+
+    // co_await pool.sleep_for(d)：挂起期间不占用任何线程，到期后由工作线程恢复
+    struct SleepAwaiter {
+        ThreadPool& pool;
+        Clock::duration delay;
+
+        bool await_ready() const noexcept { return delay <= Clock::duration::zero(); }
+        void await_suspend(std::coroutine_handle<> handle) {
+            pool.schedule_after(delay, [handle] { handle.resume(); });
+        }
+        void await_resume() const noexcept {}
+    };
+
+    SleepAwaiter sleep_for(Clock::duration delay) {
+        return SleepAwaiter{*this, delay};
+    }
+#endif
+
+    // 运行指标快照（读取各线程的单写者计数器，不影响工作线程）
+    Stats stats() const {
+        Stats result;
+        result.workers.resize(slots_.size());
         {
             std::lock_guard<std::mutex> lock(mtx_);
-            if (stop_) throw std::runtime_error("Enqueue on stopped thread pool");
-            tasks_.emplace([task] {(*task)(); });    // 原地构造异步执行的任务
+            for (size_t i = 0; i < slots_.size(); ++i) result.workers[i].active = slots_[i].active;
+        }
+        auto accumulate = [](WorkerStats& into, const WorkerStats& from) {
+            into.executed += from.executed;
+            into.idleNs += from.idleNs;
+            into.emptyPolls += from.emptyPolls;
+            into.spinHits += from.spinHits;
+            into.parks += from.parks;
+            into.localPushes += from.localPushes;
+            into.lifoHits += from.lifoHits;
+            into.steals += from.steals;
+            into.lockContended += from.lockContended;
+            into.lockWaitNs += from.lockWaitNs;
+            into.waitNs.merge(from.waitNs);
+            into.runNs.merge(from.runNs);
+            into.queueDepth.merge(from.queueDepth);
+        };
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            const WorkerSlot& slot = slots_[i];
+            WorkerStats& out = result.workers[i];
+            out.cpu = slot.cpu;
+            for (size_t lane = 0; lane < kLaneCount; ++lane) {
+                out.executed += slot.counters.executed[lane].load(std::memory_order_relaxed);
+                slot.counters.wait[lane].snapshotInto(out.waitNs);
+            }
+            out.idleNs = slot.metrics.idleNs.load();
+            out.emptyPolls = slot.metrics.emptyPolls.load();
+            out.spinHits = slot.metrics.spinHits.load();
+            out.parks = slot.metrics.parks.load();
+            out.localPushes = slot.metrics.localPushes.load();
+            out.lifoHits = slot.metrics.lifoHits.load();
+            out.steals = slot.metrics.steals.load();
+            out.lockContended = slot.metrics.lockContended.load();
+            out.lockWaitNs = slot.metrics.lockWaitNs.load();
+            slot.metrics.runNs.snapshotInto(out.runNs);
+            slot.metrics.queueDepth.snapshotInto(out.queueDepth);
+            accumulate(result.total, out);
+        }
+        for (size_t lane = 0; lane < kLaneCount; ++lane) {
+            result.total.executed += externalStats_.executed[lane].load(std::memory_order_relaxed);
+            externalStats_.wait[lane].snapshotInto(result.total.waitNs);
+        }
+        result.queueDepth = queuedApprox();
+        result.liveThreads = liveThreads_.load();
+        result.idleThreads = idle_.load();
+        result.spinningThreads = spinning_.load();
+        result.parkedThreads = parkedCount_.load();
+        result.producerLockContended = producerLockContended_.load(std::memory_order_relaxed);
+        result.taskExceptions = taskExceptions_.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    // 各通道统计：下标为 Priority 的数值，kDeadlineLane 为截止时间通道
+    std::array<LaneStats, kLaneCount> lane_stats() const {
+        std::array<LaneStats, kLaneCount> result;
+        for (size_t lane = 0; lane < kLaneCount; ++lane) {
+            LaneStats& out = result[lane];
+            out.depth = lane == kDeadlineLane ? deadlineCount_.load() : lanes_[lane]->size_approx();
+            out.executed = 0;
+            out.deadlineMisses = 0;
+            auto collect = [&](const LaneCounters& counters) {
+                out.executed += counters.executed[lane].load(std::memory_order_relaxed);
+                out.deadlineMisses += counters.deadlineMisses[lane].load(std::memory_order_relaxed);
+                counters.wait[lane].snapshotInto(out.waitNs);
+            };
+            for (const auto& slot : slots_) collect(slot.counters);
+            collect(externalStats_);
         }
-        cv_.notify_all();
         return result;
     }
 
+    // 批量提交 [first, last) 中的可调用对象（按值复制），返回与之一一对应的 future
+    template<typename InputIt>
+    auto enqueue_bulk(InputIt first, InputIt last)
+        -> std::vector<std::future<std::invoke_result_t<std::decay_t<decltype(*first)>>>> {
+        using ReturnType = std::invoke_result_t<std::decay_t<decltype(*first)>>;
+        std::vector<Task> batch;
+        std::vector<std::future<ReturnType>> results;
+        if constexpr (std::is_base_of<std::forward_iterator_tag,
+                          typename std::iterator_traits<InputIt>::iterator_category>::value) {
+            size_t n = static_cast<size_t>(std::distance(first, last));
+            batch.reserve(n);
+            results.reserve(n);
+        }
+        for (; first != last; ++first) {
+            auto [task, result] = makePromiseTask(*first);
+            batch.emplace_back(std::move(task));
+            results.push_back(std::move(result));
+        }
+        pushBatch(batch);
+        return results;
+    }
+
+    // 批量提交 count 个由 generator(i) 生成的可调用对象，返回与之一一对应的 future
+    template<typename Generator>
+    auto enqueue_bulk(size_t count, Generator&& generator)
+        -> std::vector<std::future<std::invoke_result_t<std::decay_t<std::invoke_result_t<Generator&, size_t>>>>> {
+        using ReturnType = std::invoke_result_t<std::decay_t<std::invoke_result_t<Generator&, size_t>>>;
+        std::vector<Task> batch;
+        std::vector<std::future<ReturnType>> results;
+        batch.reserve(count);
+        results.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            auto [task, result] = makePromiseTask(generator(i));
+            batch.emplace_back(std::move(task));
+            results.push_back(std::move(result));
+        }
+        pushBatch(batch);
+        return results;
+    }
+
+    // 批量提交 [first, last) 中的可调用对象，返回一个整体完成句柄：
+    // 全部任务结束后就绪；若有任务抛出异常，句柄携带第一个异常
+    template<typename InputIt>
+    std::future<void> submit_range(InputIt first, InputIt last) {
+        auto group = std::make_shared<CompletionGroup>();
+        std::future<void> done = group->promise.get_future();
+        std::vector<Task> batch;
+        for (; first != last; ++first) {
+            batch.emplace_back([group, fn = std::decay_t<decltype(*first)>(*first)]() mutable {
+                try {
+                    fn();
+                } catch (...) {
+                    group->fail(std::current_exception());
+                }
+                group->finishOne();
+            });
+        }
+        if (batch.empty()) {
+            group->promise.set_value();
+            return done;
+        }
+        group->remaining.store(batch.size(), std::memory_order_relaxed);
+        pushBatch(batch);
+        return done;
+    }
+
 private:
-    std::vector<std::thread> workers_;   // 工作线程
-    std::queue<std::function<void()>> tasks_;   // 任务队列（擦除可调用对象的类型）
-    std::mutex mtx_;
-    std::condition_variable cv_;
-    bool stop_;
+    // 队列元素：任务 + 入队时间（用于按等待时长扩容和统计）+ 截止时间（仅截止时间通道）
+    struct QueuedTask {
+        Task task;
+        Clock::time_point enqueuedAt;
+        Clock::time_point deadline = Clock::time_point::max();
+    };
+
+    // 每条通道的计数：工作线程各自一份（单写者），非工作线程共享一份
+    struct LaneCounters {
+        std::array<LatencyHistogram, kLaneCount> wait;
+        std::array<std::atomic<uint64_t>, kLaneCount> executed{};
+        std::array<std::atomic<uint64_t>, kLaneCount> deadlineMisses{};
+    };
+
+    // 每个工作线程的运行指标（只由该槽位上的线程写入）
+    struct WorkerMetrics {
+        LatencyHistogram runNs;
+        LatencyHistogram queueDepth;
+        SingleWriterCounter idleNs;
+        SingleWriterCounter emptyPolls;
+        SingleWriterCounter spinHits;
+        SingleWriterCounter parks;
+        SingleWriterCounter localPushes;
+        SingleWriterCounter lifoHits;
+        SingleWriterCounter steals;
+        SingleWriterCounter lockContended;
+        SingleWriterCounter lockWaitNs;
+    };
+
+    // 加权轮询游标：当前通道及其剩余份额
+    struct LaneCursor {
+        size_t lane = kLaneCount - 1;   // 首次推进后从 High 开始
+        size_t credits = 0;
+    };
+
+    // 工作线程槽位：数量固定为 maxThreads，线程被回收后槽位可复用
+    struct WorkerSlot {
+        std::thread thread;
+        bool active = false;
+        int cpu = -1;           // 绑定的 CPU（-1 表示不绑核）；回收后重建的线程沿用同一个 CPU
+        LaneCursor cursor;
+        LaneCounters counters;
+        WorkerMetrics metrics;
+        Parker parker;          // 空闲时在此休眠；唤醒者只唤醒这一个线程
+        bool parked = false;    // 是否在 parked_ 中（受 mtx_ 保护）
+        // 本线程提交的任务：下一个任务槽位 + 本地队列（自己在底部 LIFO，其他线程从顶部窃取）
+        std::atomic<QueuedTask*> next{nullptr};
+        WorkStealingDeque<QueuedTask*> local;
+        // 以下只由本槽位上的线程访问
+        uint32_t ticks = 0;         // 取任务次数，用于定期优先检查全局通道
+        uint32_t lifoStreak = 0;    // 连续从槽位取任务的次数
+        uint64_t rng = 0;           // 窃取时选择起点的随机数状态
+    };
+
+    static constexpr uint32_t kGlobalPollInterval = 61;  // 每取这么多次任务先看一次全局通道
+    static constexpr uint32_t kMaxLifoStreak = 3;        // 连续执行槽位任务的上限，之后先取本地队列
+
+    static size_t laneOf(Priority priority) { return static_cast<size_t>(priority); }
+
+    static Options fixedSize(size_t numThreads) {
+        Options options;
+        options.coreThreads = numThreads;
+        options.maxThreads = numThreads;
+        return options;
+    }
+
+    // 当前线程是否为本线程池的工作线程
+    static const ThreadPool*& currentPool() {
+        static thread_local const ThreadPool* pool = nullptr;
+        return pool;
+    }
+    static size_t& currentSlot() {
+        static thread_local size_t slot = 0;
+        return slot;
+    }
+    bool inWorkerThread() const { return currentPool() == this; }
+
+    // submit_range 的整体完成状态
+    struct CompletionGroup {
+        std::atomic<size_t> remaining{0};
+        std::promise<void> promise;
+        std::mutex errorMtx;
+        std::exception_ptr error;   // 第一个异常
+
+        void fail(std::exception_ptr e) {
+            std::lock_guard<std::mutex> lock(errorMtx);
+            if (!error) error = e;
+        }
+
+        void finishOne() {
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+            if (error) promise.set_exception(error);
+            else promise.set_value();
+        }
+    };
+
+    // 成员计数器在作用域结束时减一（登记/注销空闲线程、阻塞生产者）
+    struct CountGuard {
+        std::atomic<size_t>& counter;
+        ~CountGuard() { counter.fetch_sub(1); }
+    };
+
+    void pushTask(Task&& task, size_t lane, Clock::time_point deadline = Clock::time_point::max()) {
+        if (stop_.load()) throw std::runtime_error("Enqueue on stopped thread pool");
+        if (lane == laneOf(Priority::Normal) && deadline == Clock::time_point::max() && inWorkerThread()) {
+            pushLocal(std::move(task));
+            return;
+        }
+        QueuedTask item{std::move(task), Clock::now(), deadline};
+        if (tryPushLane(lane, item) || handleFull(lane, item)) {
+            afterPush(1);
+        }
+    }
+
+    // 入队到指定通道；通道已满时返回 false，且 item 保持不变
+    bool tryPushLane(size_t lane, QueuedTask& item) {
+        if (lane != kDeadlineLane) return lanes_[lane]->try_push(std::move(item));
+        std::lock_guard<std::mutex> lock(deadlineMtx_);
+        if (deadlineHeap_.size() >= options_.queueCapacity) return false;
+        deadlineHeap_.push_back(std::move(item));
+        std::push_heap(deadlineHeap_.begin(), deadlineHeap_.end(), laterDeadline);
+        publishDeadlineHeadLocked();
+        return true;
+    }
+
+    // 从指定通道出队（截止时间通道取最早截止的任务）
+    bool tryPopLane(size_t lane, QueuedTask& item) {
+        if (lane != kDeadlineLane) return lanes_[lane]->try_pop(item);
+        if (deadlineCount_.load() == 0) return false;
+        std::lock_guard<std::mutex> lock(deadlineMtx_);
+        if (deadlineHeap_.empty()) return false;
+        std::pop_heap(deadlineHeap_.begin(), deadlineHeap_.end(), laterDeadline);
+        item = std::move(deadlineHeap_.back());
+        deadlineHeap_.pop_back();
+        publishDeadlineHeadLocked();
+        return true;
+    }
+
+    static bool laterDeadline(const QueuedTask& a, const QueuedTask& b) {
+        return a.deadline > b.deadline;    // 小顶堆：最早的截止时间在堆顶
+    }
+
+    // 发布截止时间通道的任务数和最早截止时间，供工作线程无锁判断
+    void publishDeadlineHeadLocked() {
+        deadlineCount_.store(deadlineHeap_.size());
+        earliestDeadline_.store(deadlineHeap_.empty() ? Clock::duration::max().count()
+                                                      : deadlineHeap_.front().deadline.time_since_epoch().count());
+    }
+
+    // 取下一个任务：先看是否有即将到期的截止时间任务，否则按权重在各通道间轮询
+    bool popAny(LaneCursor& cursor, QueuedTask& item, size_t& lane) {
+        if (deadlineCount_.load(std::memory_order_relaxed) > 0) {
+            auto urgentBefore = (Clock::now() + options_.deadlineUrgency).time_since_epoch().count();
+            if (earliestDeadline_.load(std::memory_order_relaxed) <= urgentBefore && tryPopLane(kDeadlineLane, item)) {
+                lane = kDeadlineLane;
+                return true;
+            }
+        }
+        for (size_t attempt = 0; attempt <= kLaneCount; ++attempt) {
+            if (cursor.credits == 0) {
+                cursor.lane = (cursor.lane + 1) % kLaneCount;
+                cursor.credits = std::max<size_t>(1, options_.laneWeights[cursor.lane]);
+            }
+            if (tryPopLane(cursor.lane, item)) {
+                --cursor.credits;
+                lane = cursor.lane;
+                return true;
+            }
+            cursor.credits = 0;     // 该通道为空，轮到下一条
+        }
+        return false;
+    }
+
+    // 本地任务从任务内存池分配（入队时间在此记录），取出时移出并释放
+    static QueuedTask* newLocalTask(Task&& task) {
+        void* memory = TaskMemoryPool::allocate(sizeof(QueuedTask));
+        return new (memory) QueuedTask{std::move(task), Clock::now()};
+    }
+
+    static void takeLocalTask(QueuedTask* task, QueuedTask& item) {
+        item = std::move(*task);
+        task->~QueuedTask();
+        TaskMemoryPool::deallocate(task, sizeof(QueuedTask));
+    }
+
+    // 工作线程内部提交：新任务进入槽位，被挤出的旧任务进入本地队列供其他线程窃取
+    void pushLocal(Task&& task) {
+        WorkerSlot& slot = slots_[currentSlot()];
+        slot.metrics.localPushes.add();
+        QueuedTask* previous = slot.next.exchange(newLocalTask(std::move(task)), std::memory_order_acq_rel);
+        if (previous) slot.local.push(previous);
+        afterPush(1);   // 没有自旋者时唤醒一个线程：它可以窃取本地队列，或在休眠前接手槽位中的任务
+    }
+
+    static QueuedTask* takeNext(WorkerSlot& slot) {
+        if (slot.next.load(std::memory_order_relaxed) == nullptr) return nullptr;
+        return slot.next.exchange(nullptr, std::memory_order_acquire);
+    }
+
+    // 本线程的槽位和本地队列
+    bool popLocal(WorkerSlot& slot, QueuedTask& item) {
+        bool preferNext = slot.lifoStreak < kMaxLifoStreak;
+        QueuedTask* task = preferNext ? takeNext(slot) : nullptr;
+        bool fromNext = task != nullptr;
+        if (!task && !slot.local.pop(task)) task = nullptr;
+        if (!task && !preferNext) {
+            task = takeNext(slot);
+            fromNext = task != nullptr;
+        }
+        if (!task) return false;
+        if (fromNext) {
+            ++slot.lifoStreak;
+            slot.metrics.lifoHits.add();
+        } else {
+            slot.lifoStreak = 0;
+        }
+        takeLocalTask(task, item);
+        return true;
+    }
+
+    static uint64_t nextRandom(uint64_t& state) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    // 从随机起点依次窃取其他线程的本地队列；takeNext 为 true 时也拿走对方槽位中的任务
+    // self 为当前槽位（外部线程传 slots_.size()）
+    bool stealTask(size_t self, uint64_t& rng, QueuedTask& item, bool takeNextSlot) {
+        size_t n = slots_.size();
+        size_t start = static_cast<size_t>(nextRandom(rng) % n);
+        for (size_t k = 0; k < n; ++k) {
+            size_t victimIndex = (start + k) % n;
+            if (victimIndex == self) continue;
+            WorkerSlot& victim = slots_[victimIndex];
+            QueuedTask* task = nullptr;
+            for (int attempt = 0; attempt < 2 && victim.local.size() > 0; ++attempt) {
+                if (victim.local.steal(task)) break;
+                task = nullptr;     // 与其他窃取者竞争失败，重试一次
+            }
+            if (!task && takeNextSlot) task = takeNext(victim);
+            if (task) {
+                takeLocalTask(task, item);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 工作线程取下一个任务：槽位 / 本地队列 -> 全局通道 -> 窃取；
+    // 每 kGlobalPollInterval 次先看全局通道；takeNextSlot 见 stealTask
+    bool findTask(size_t slotIndex, QueuedTask& item, size_t& lane, bool takeNextSlot) {
+        WorkerSlot& slot = slots_[slotIndex];
+        if (++slot.ticks % kGlobalPollInterval == 0 && popAny(slot.cursor, item, lane)) {
+            slot.lifoStreak = 0;
+            return true;
+        }
+        if (popLocal(slot, item)) {
+            lane = laneOf(Priority::Normal);
+            return true;
+        }
+        if (popAny(slot.cursor, item, lane)) {
+            slot.lifoStreak = 0;
+            return true;
+        }
+        if (stealTask(slotIndex, slot.rng, item, takeNextSlot)) {
+            lane = laneOf(Priority::Normal);
+            slot.lifoStreak = 0;
+            slot.metrics.steals.add();
+            return true;
+        }
+        return false;
+    }
+
+    size_t globalQueuedApprox() const {
+        size_t total = deadlineCount_.load(std::memory_order_relaxed);
+        for (const auto& lane : lanes_) total += lane->size_approx();
+        return total;
+    }
+
+    // 排队任务数（近似）：全局通道 + 各线程本地队列（不含槽位中的任务）
+    size_t queuedApprox() const {
+        size_t total = globalQueuedApprox();
+        for (const auto& slot : slots_) total += slot.local.size();
+        return total;
+    }
+
+    // 记录任务开始执行时的等待时间（shared 为 true 表示多个线程共享这份计数）
+    static Clock::time_point recordStart(LaneCounters& counters, size_t lane, const QueuedTask& item, bool shared) {
+        auto now = Clock::now();
+        uint64_t waitNs = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - item.enqueuedAt).count());
+        bool missed = lane == kDeadlineLane && now > item.deadline;
+        if (shared) {
+            counters.wait[lane].recordShared(waitNs);
+            counters.executed[lane].fetch_add(1, std::memory_order_relaxed);
+            if (missed) counters.deadlineMisses[lane].fetch_add(1, std::memory_order_relaxed);
+        } else {
+            counters.wait[lane].record(waitNs);
+            auto& executed = counters.executed[lane];
+            executed.store(executed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            if (missed) {
+                auto& misses = counters.deadlineMisses[lane];
+                misses.store(misses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+        }
+        return now;
+    }
+
+    static uint64_t elapsedNs(Clock::time_point from, Clock::time_point to) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+    }
+
+    // 获取 mtx_ 并统计竞争：先 try_lock，失败时才计时阻塞加锁；
+    // 工作线程记入自己的计数器，其他线程记入共享计数器（只在已经发生竞争的慢路径上做原子加）
+    std::unique_lock<std::mutex> lockPoolMutex() {
+        std::unique_lock<std::mutex> lock(mtx_, std::try_to_lock);
+        if (lock.owns_lock()) return lock;
+        auto start = Clock::now();
+        lock.lock();
+        if (currentPool() == this) {
+            WorkerMetrics& metrics = slots_[currentSlot()].metrics;
+            metrics.lockContended.add();
+            metrics.lockWaitNs.add(elapsedNs(start, Clock::now()));
+        } else {
+            producerLockContended_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return lock;
+    }
+
+    // 边等边干的一步：工作线程按自己的取任务顺序（槽位、本地队列、全局通道、窃取）执行一个任务，
+    // 其他线程退化为 run_pending_task
+    bool helpOnce() {
+        if (!inWorkerThread()) return run_pending_task();
+        size_t slotIndex = currentSlot();
+        WorkerSlot& slot = slots_[slotIndex];
+        QueuedTask item;
+        size_t lane;
+        if (!findTask(slotIndex, item, lane, true)) return false;
+        afterPop();
+        auto start = recordStart(slot.counters, lane, item, false);
+        runTask(item);
+        slot.metrics.runNs.record(elapsedNs(start, Clock::now()));
+        return true;
+    }
+
+    // 整批入队（无锁），再唤醒 min(批大小, 空闲线程数) 个线程
+    void pushBatch(std::vector<Task>& batch) {
+        if (batch.empty()) return;
+        if (stop_.load()) throw std::runtime_error("Enqueue on stopped thread pool");
+        auto now = Clock::now();
+        size_t pushed = 0;
+        size_t lane = laneOf(Priority::Normal);
+        for (auto& task : batch) {
+            QueuedTask item{std::move(task), now};
+            if (tryPushLane(lane, item)) {
+                ++pushed;
+                continue;
+            }
+            afterPush(pushed);      // 队列已满：先唤醒线程处理已入队的任务，再按拒绝策略处理
+            pushed = handleFull(lane, item) ? 1 : 0;
+        }
+        afterPush(pushed);
+    }
+
+    // 定时线程投递到期任务：通道已满时不按拒绝策略处理，而是等待空位。
+    // CallerRuns 会让定时线程自己执行用户代码并拖住其他定时器，FailFast 会丢掉整批到期任务；
+    // 只有线程池停止时才抛出，由时间轮丢弃剩下的任务
+    void pushTimerBatch(std::vector<Task>& batch) {
+        auto now = Clock::now();
+        size_t pushed = 0;
+        size_t lane = laneOf(Priority::Normal);
+        for (auto& task : batch) {
+            QueuedTask item{std::move(task), now};
+            if (tryPushLane(lane, item)) {
+                ++pushed;
+                continue;
+            }
+            afterPush(pushed);      // 先唤醒线程处理已入队的任务，空位才会出现
+            pushed = waitUntilPushed(lane, item, std::nullopt) ? 1 : 0;
+        }
+        afterPush(pushed);
+    }
+
+    // 通道已满时按拒绝策略处理；返回 true 表示任务最终进入了队列
+    // （截止时间通道的"最旧任务"指堆顶，即截止时间最早的任务）
+    bool handleFull(size_t lane, QueuedTask& item) {
+        switch (options_.rejectPolicy) {
+        case RejectPolicy::FailFast:
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            throw QueueFullError();
+        case RejectPolicy::CallerRuns:
+            callerRuns_.fetch_add(1, std::memory_order_relaxed);
+            item.task();
+            return false;
+        case RejectPolicy::DropOldest:
+            while (true) {
+                QueuedTask oldest;
+                if (tryPopLane(lane, oldest)) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);   // oldest 析构：promise 被销毁
+                }
+                if (tryPushLane(lane, item)) return true;
+            }
+        case RejectPolicy::Block:
+        default:
+            if (inWorkerThread()) {     // 工作线程阻塞等待空位可能导致所有线程互相等待
+                callerRuns_.fetch_add(1, std::memory_order_relaxed);
+                item.task();
+                return false;
+            }
+            return waitUntilPushed(lane, item, std::nullopt);
+        }
+    }
+
+    // 等待队列出现空位并入队；超过 deadline 返回 false
+    bool waitUntilPushed(size_t lane, QueuedTask& item, std::optional<Clock::time_point> deadline) {
+        for (int spin = 0; spin < 64; ++spin) {     // 空位通常很快出现，先短暂让出 CPU
+            if (tryPushLane(lane, item)) return true;
+            if (deadline && Clock::now() >= *deadline) return false;
+            std::this_thread::yield();
+        }
+        std::unique_lock<std::mutex> lock(spaceMtx_);
+        blockedProducers_.fetch_add(1);
+        CountGuard unregister{blockedProducers_};
+        while (true) {
+            if (tryPushLane(lane, item)) return true;
+            if (stop_.load()) throw std::runtime_error("Enqueue on stopped thread pool");
+            if (!deadline) {
+                spaceCv_.wait(lock);
+            } else if (spaceCv_.wait_until(lock, *deadline) == std::cv_status::timeout) {
+                return tryPushLane(lane, item);
+            }
+        }
+    }
+
+    // 入队后：自旋中的线程会自己取到任务，只为超出自旋者数量的部分唤醒休眠线程
+    // （单个任务：没有线程在自旋时唤醒一个）；空闲线程不够时考虑扩容
+    void afterPush(size_t count) {
+        if (count == 0) return;
+        // 与 waitForTask() 中的 spinning_ / parked_ 登记配对：要么工作线程看到新任务，要么这里看到它
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        size_t spinning = spinning_.load(std::memory_order_relaxed);
+        size_t wake = count > spinning ? count - spinning : 0;
+        if (wake > 0 && parkedCount_.load(std::memory_order_relaxed) > 0) {
+            wake = wakeParked(wake);
+        } else {
+            wake = 0;
+        }
+        if (spinning + wake < count) growIfNeeded(Clock::duration::zero());
+    }
+
+    // 唤醒至多 count 个休眠线程，返回实际唤醒数；被唤醒的线程由唤醒者计入 spinning_，
+    // 这样在它真正开始运行之前，后续提交不会再去唤醒别的线程
+    size_t wakeParked(size_t count) {
+        std::vector<size_t> woken;
+        {
+            auto lock = lockPoolMutex();
+            woken = takeParkedLocked(count);
+        }
+        for (size_t index : woken) slots_[index].parker.unpark();   // 不持锁唤醒，被唤醒的线程不会立刻撞上锁
+        return woken.size();
+    }
+
+    // 从 parked_ 取出至多 count 个线程（后进先出：最近休眠的线程缓存更热）
+    std::vector<size_t> takeParkedLocked(size_t count) {
+        std::vector<size_t> taken;
+        while (taken.size() < count && !parked_.empty()) {
+            size_t index = parked_.back();
+            parked_.pop_back();
+            slots_[index].parked = false;
+            spinning_.fetch_add(1);
+            taken.push_back(index);
+        }
+        parkedCount_.store(parked_.size());
+        return taken;
+    }
+
+    void unparkSelfLocked(size_t slotIndex) {
+        slots_[slotIndex].parked = false;
+        parked_.erase(std::find(parked_.begin(), parked_.end(), slotIndex));
+        parkedCount_.store(parked_.size());
+    }
+
+    // 自旋者取到任务、退出自旋：若它是最后一个自旋者而队列仍有任务，接力唤醒一个休眠线程
+    void stopSpinning() {
+        if (spinning_.fetch_sub(1) == 1) wakeIfBacklogged();
+    }
+
+    void wakeIfBacklogged() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (spinning_.load(std::memory_order_relaxed) == 0 && parkedCount_.load(std::memory_order_relaxed) > 0 &&
+            queuedApprox() > 0) {
+            wakeParked(1);
+        }
+    }
+
+    // 休眠前的自旋 / 让出阶段：期间反复取任务
+    bool spinForTask(size_t slotIndex, QueuedTask& item, size_t& lane) {
+        for (size_t round = 0; round < options_.idleSpins + options_.idleYields; ++round) {
+            if (findTask(slotIndex, item, lane, false)) return true;
+            if (stop_.load(std::memory_order_relaxed)) return false;
+            if (round < options_.idleSpins) {
+                for (int i = 0; i < 32; ++i) cpuRelax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        return false;
+    }
+
+    // 出队后：若有生产者因队列满而阻塞，唤醒其中一个
+    void afterPop() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (blockedProducers_.load(std::memory_order_relaxed) > 0) {
+            { std::lock_guard<std::mutex> lock(spaceMtx_); }
+            spaceCv_.notify_one();
+        }
+    }
+
+    // 没有空闲线程时判断是否扩容：尚无线程、排队过深或任务等待过久
+    void growIfNeeded(Clock::duration observedWait) {
+        size_t live = liveThreads_.load(std::memory_order_relaxed);
+        if (stop_.load(std::memory_order_relaxed) || live >= options_.maxThreads) return;
+        bool overloaded = live == 0 ||
+                          queuedApprox() >= options_.growQueueDepth ||
+                          observedWait >= options_.growQueueLatency;
+        if (!overloaded) return;
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (stop_ || idle_.load() > 0 || liveThreads_.load() >= options_.maxThreads) return;
+        spawnWorkerLocked();
+        if (liveThreads_.load() > options_.coreThreads) ++grown_;
+    }
+
+    void spawnWorkerLocked() {
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            WorkerSlot& slot = slots_[i];
+            if (slot.active) continue;
+            if (slot.thread.joinable()) slot.thread.join();   // 已回收的线程已经退出（或即将退出）
+            slot.active = true;
+            slot.thread = std::thread([this, i] { workerLoop(i); });
+            size_t live = liveThreads_.fetch_add(1) + 1;
+            peakThreads_ = std::max(peakThreads_, live);
+            return;
+        }
+    }
+
+    // 队列为空时先自旋再休眠；返回 false 表示线程应当退出（线程池停止或空闲超时被回收）
+    bool waitForTask(size_t slotIndex, QueuedTask& item, size_t& lane) {
+        WorkerSlot& slot = slots_[slotIndex];
+        WorkerMetrics& metrics = slot.metrics;
+        auto idleSince = Clock::now();
+        struct IdleGuard {
+            WorkerMetrics& metrics;
+            Clock::time_point since;
+            ~IdleGuard() { metrics.idleNs.add(elapsedNs(since, Clock::now())); }
+        } idleGuard{metrics, idleSince};
+        idle_.fetch_add(1);
+        CountGuard unregister{idle_};
+        spinning_.fetch_add(1);
+        auto idleDeadline = idleSince + options_.keepAlive;
+        while (true) {
+            // 1. 自旋 / 让出（计入 spinning_，提交方据此省去唤醒）
+            if (spinForTask(slotIndex, item, lane)) {
+                metrics.spinHits.add();
+                stopSpinning();
+                return true;
+            }
+            metrics.emptyPolls.add();
+
+            // 2. 退出自旋并登记休眠，登记后再检查一次，避免丢失唤醒
+            spinning_.fetch_sub(1);
+            std::unique_lock<std::mutex> lock = lockPoolMutex();
+            slot.parked = true;
+            parked_.push_back(slotIndex);
+            parkedCount_.store(parked_.size());
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool found = findTask(slotIndex, item, lane, true);
+            if (found || stop_) {
+                if (slot.parked) {
+                    unparkSelfLocked(slotIndex);
+                } else {
+                    spinning_.fetch_sub(1);     // 唤醒者已把本线程计入自旋者，撤销
+                }
+                lock.unlock();
+                if (found) wakeIfBacklogged();
+                return found;                   // 停止且无剩余任务时退出
+            }
+            lock.unlock();
+
+            // 3. 休眠；非核心线程最多休眠到 keepAlive 到期
+            metrics.parks.add();
+            bool core = liveThreads_.load() <= options_.coreThreads;
+            if (core) {
+                slot.parker.park();
+            } else {
+                slot.parker.park_until(idleDeadline);
+            }
+
+            lock = lockPoolMutex();
+            if (!slot.parked) continue;     // 被唤醒：唤醒者已把本线程计入 spinning_，回到自旋阶段
+            // 超时或伪唤醒：自行撤销登记
+            unparkSelfLocked(slotIndex);
+            if (!core && Clock::now() >= idleDeadline && !stop_ && liveThreads_.load() > options_.coreThreads) {
+                if (findTask(slotIndex, item, lane, true)) {
+                    lock.unlock();
+                    wakeIfBacklogged();
+                    return true;
+                }
+                // 非核心线程空闲超时：回收（线程对象留在槽位中，由下次复用或析构时 join）
+                liveThreads_.fetch_sub(1);
+                ++retired_;
+                slot.active = false;
+                return false;
+            }
+            spinning_.fetch_add(1);
+        }
+    }
+
+    // 执行一个出队的任务。enqueue / async 的异常已经存进 future，只有 post() 的任务会在这里抛出：
+    // 拦下并计数，不让它结束工作线程（进而 std::terminate），也不让它从 help_until 落到无关的调用方
+    void runTask(QueuedTask& item) noexcept {
+        try {
+            item.task();
+        } catch (...) {
+            taskExceptions_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void workerLoop(size_t slotIndex) {
+        if (slots_[slotIndex].cpu >= 0) Topology::pinCurrentThread(slots_[slotIndex].cpu);
+        currentPool() = this;
+        currentSlot() = slotIndex;
+        slots_[slotIndex].rng = 0x9E3779B97F4A7C15ull * (slotIndex + 1);
+        while (true) {
+            QueuedTask item;
+            size_t lane;
+            WorkerSlot& slot = slots_[slotIndex];
+            if (!findTask(slotIndex, item, lane, false)) {
+                slot.metrics.emptyPolls.add();
+                if (!waitForTask(slotIndex, item, lane)) return;
+            }
+            afterPop();
+            // 只看全局通道和自己的本地队列：每个任务都去读其他线程的队列会造成缓存行来回传递
+            slot.metrics.queueDepth.record(globalQueuedApprox() + slot.local.size());
+            auto start = recordStart(slot.counters, lane, item, false);
+            if (idle_.load(std::memory_order_relaxed) == 0) {
+                growIfNeeded(start - item.enqueuedAt);
+            }
+            runTask(item); // 不持有任何锁执行任务（有可能任务较为耗时）
+            slot.metrics.runNs.record(elapsedNs(start, Clock::now()));
+        }
+    }
+
+    Options options_;
+    std::vector<WorkerSlot> slots_;      // 工作线程槽位（受 mtx_ 保护）
+    std::array<std::unique_ptr<BoundedQueue<QueuedTask>>, kPriorityLanes> lanes_;  // 优先级通道（擦除可调用对象的类型）
+    std::mutex deadlineMtx_;                 // 截止时间通道（小顶堆）
+    std::vector<QueuedTask> deadlineHeap_;
+    std::atomic<size_t> deadlineCount_;
+    std::atomic<Clock::rep> earliestDeadline_{Clock::duration::max().count()};
+    LaneCounters externalStats_;         // 非工作线程（run_pending_task）执行任务的计数
+    mutable std::mutex mtx_;             // 休眠线程登记、线程创建/回收
+    std::vector<size_t> parked_;         // 在 Parker 上休眠的工作线程槽位（受 mtx_ 保护）
+    std::atomic<size_t> parkedCount_{0}; // parked_.size()，供提交方无锁判断
+    std::atomic<size_t> spinning_{0};    // 正在自旋找任务的线程数（含已被唤醒、尚未开始运行的线程）
+    std::mutex spaceMtx_;                // 队列满时阻塞的生产者
+    std::condition_variable spaceCv_;
+    std::atomic<size_t> liveThreads_;    // 存活线程数（在 mtx_ 内修改）
+    std::atomic<size_t> idle_;           // 正在等待任务的线程数（自旋中 + 休眠中）
+    std::atomic<size_t> blockedProducers_;
+    // 以下成员受 mtx_ 保护
+    size_t peakThreads_;
+    uint64_t grown_;
+    uint64_t retired_;
+    // 拒绝策略计数
+    std::atomic<uint64_t> rejected_;
+    std::atomic<uint64_t> callerRuns_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<uint64_t> producerLockContended_{0};
+    std::atomic<uint64_t> taskExceptions_{0};   // post() 任务抛出的异常数
+    std::atomic<bool> stop_;
+    TimerWheel timers_;                  // 最后构造、最先停止：定时线程会调用 pushTimerBatch
 };
 
 
-#endif // THREADPOOL_H
\ No newline at end of file
+#endif // THREADPOOL_H
@@ -0,0 +1,337 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+/*
+ **************** 分层时间轮 ****************
+ 参考：Varghese & Lauck, "Hashed and Hierarchical Timing Wheels"
+ 设计目标：
+    1. 4 层 × 256 槽，每格一个刻度（默认 1 ms），覆盖 2^32 个刻度（1 ms 时约 49 天），更远的定时器按最大范围放置
+    2. 定时器节点存放在连续数组中，每个槽位是按下标链接的双向链表：插入、取消均为 O(1)，
+       数十万个定时器只占一块连续内存，没有逐个节点的堆分配
+    3. 单个定时线程推进时间轮，到期任务整批交给分发函数（例如线程池入队），定时线程自身不执行用户代码
+    4. 没有定时器时定时线程无限期休眠；否则只睡到第 0 层下一个非空槽位（或下一次逐级下放）为止
+    5. 周期任务复用同一个节点重新插入，句柄在整个生命周期内有效；上一次触发仍在执行时跳过本次触发
+    6. 定时线程在第一次调度时才启动
+*/
+
+#include "Task.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// 定时器句柄：节点下标 + 代数（节点被回收复用后旧句柄自动失效）
+struct TimerHandle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool valid() const { return index != UINT32_MAX; }
+};
+
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Task = UniqueFunction<void()>;
+    using Dispatch = UniqueFunction<void(std::vector<Task>&)>;  // 到期任务的去处，在定时线程中调用
+
+    static constexpr size_t kLevels = 4;
+    static constexpr size_t kSlotBits = 8;
+    static constexpr size_t kSlots = size_t(1) << kSlotBits;      // 每层 256 槽
+    static constexpr uint64_t kMaxDelta = (uint64_t(1) << (kLevels * kSlotBits)) - 1;
+
+    TimerWheel(Clock::duration tick, Dispatch dispatch)
+        : tick_(tick), dispatch_(std::move(dispatch)), origin_(Clock::now()), current_(0),
+          wakeTick_(UINT64_MAX), count_(0), freeHead_(kNil), stop_(false) {
+        if (tick_ <= Clock::duration::zero()) throw std::invalid_argument("TimerWheel tick must be positive");
+        heads_.fill(kNil);
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    ~TimerWheel() { stop(); }
+
+    // 在 when 时刻（或之后的第一个刻度）把 task 交给分发函数
+    TimerHandle schedule_at(Clock::time_point when, Task task) {
+        return insert(when, Clock::duration::zero(), std::move(task));
+    }
+
+    // 每隔 period 触发一次 fn，第一次在 first 时刻；fn 可能在多个工作线程上先后执行，但不会重叠
+    TimerHandle schedule_periodic(Clock::time_point first, Clock::duration period, Task fn) {
+        if (period <= Clock::duration::zero()) throw std::invalid_argument("Timer period must be positive");
+        return insert(first, period, std::move(fn));
+    }
+
+    // 取消定时器；返回 false 表示已经触发（一次性定时器）或句柄无效
+    bool cancel(TimerHandle handle) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!handle.valid() || handle.index >= nodes_.size()) return false;
+        Node& node = nodes_[handle.index];
+        if (node.generation != handle.generation || node.slot == kNil) return false;
+        unlink(handle.index);
+        release(handle.index);
+        return true;
+    }
+
+    // 尚未触发（或周期性）的定时器个数
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return count_;
+    }
+
+    // 停止定时线程，未触发的定时器直接丢弃
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (stop_) return;
+            stop_ = true;
+        }
+        cv_.notify_one();
+        if (worker_.joinable()) worker_.join();
+        std::lock_guard<std::mutex> lock(mtx_);
+        nodes_.clear();
+        heads_.fill(kNil);
+        count_ = 0;
+    }
+
+private:
+    static constexpr uint32_t kNil = UINT32_MAX;
+
+    // 周期任务的共享状态：可调用对象只保存一份，每次触发投递一个引用它的小任务
+    struct Periodic {
+        Task fn;
+        std::atomic<bool> running{false};
+    };
+
+    // 投递出去的触发任务持有它：任务执行完（包括 fn 抛出）、或者没有执行就被销毁（分发被拒绝、线程池丢弃）时
+    // 都会清除 running，周期任务不会因为某一次触发失败而永远停止
+    struct RunningGuard {
+        std::shared_ptr<Periodic> periodic;
+
+        explicit RunningGuard(std::shared_ptr<Periodic> p) : periodic(std::move(p)) {}
+        RunningGuard(RunningGuard&&) noexcept = default;
+        RunningGuard& operator=(RunningGuard&&) = delete;
+        ~RunningGuard() {
+            if (periodic) periodic->running.store(false, std::memory_order_release);
+        }
+    };
+
+    struct Node {
+        uint32_t prev = kNil;
+        uint32_t next = kNil;           // 也用作空闲链表的链接
+        uint32_t slot = kNil;           // 所在槽位（level * kSlots + index），kNil 表示不在时间轮中
+        uint32_t generation = 0;
+        uint64_t expires = 0;           // 到期刻度
+        uint64_t period = 0;            // 周期（刻度数），0 表示一次性
+        Task task;
+        std::shared_ptr<Periodic> periodic;
+    };
+
+    TimerHandle insert(Clock::time_point when, Clock::duration period, Task task) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (stop_) throw std::runtime_error("Schedule on stopped timer wheel");
+        if (!worker_.joinable()) {
+            origin_ = Clock::now();
+            current_ = 0;
+            worker_ = std::thread([this] { run(); });
+        } else if (count_ == 0) {
+            current_ = elapsedTicks(Clock::now());   // 时间轮为空：直接跳到当前刻度，不必逐格追赶
+        }
+
+        uint32_t index = allocate();
+        Node& node = nodes_[index];
+        node.expires = tickAtOrAfter(when);
+        if (period > Clock::duration::zero()) {
+            node.period = std::max<uint64_t>(1, static_cast<uint64_t>((period + tick_ - Clock::duration(1)) / tick_));
+            node.periodic = std::make_shared<Periodic>();
+            node.periodic->fn = std::move(task);
+        } else {
+            node.period = 0;
+            node.task = std::move(task);
+        }
+        place(index);
+        ++count_;
+        bool wake = node.expires < wakeTick_;   // 比定时线程计划醒来的时间更早
+        TimerHandle handle{index, node.generation};
+        lock.unlock();
+        if (wake) cv_.notify_one();
+        return handle;
+    }
+
+    uint32_t allocate() {
+        if (freeHead_ != kNil) {
+            uint32_t index = freeHead_;
+            freeHead_ = nodes_[index].next;
+            return index;
+        }
+        if (nodes_.size() >= kNil) throw std::runtime_error("Too many timers");
+        nodes_.emplace_back();
+        return static_cast<uint32_t>(nodes_.size() - 1);
+    }
+
+    void release(uint32_t index) {
+        Node& node = nodes_[index];
+        node.task.reset();
+        node.periodic.reset();
+        node.slot = kNil;
+        node.prev = kNil;
+        ++node.generation;
+        node.next = freeHead_;
+        freeHead_ = index;
+        --count_;
+    }
+
+    // 按到期刻度与当前刻度之差选择层级：差值越大，层级越高，槽位覆盖的刻度越多
+    void place(uint32_t index) {
+        Node& node = nodes_[index];
+        uint64_t expires = std::max(node.expires, current_);
+        uint64_t delta = expires - current_;
+        if (delta > kMaxDelta) {
+            delta = kMaxDelta;
+            expires = current_ + kMaxDelta;     // 超出范围：先放在最远处，到时再重新计算
+        }
+        size_t level = 0;
+        while (level + 1 < kLevels && delta >= (uint64_t(1) << ((level + 1) * kSlotBits))) ++level;
+        size_t slot = level * kSlots + ((expires >> (level * kSlotBits)) & (kSlots - 1));
+
+        node.slot = static_cast<uint32_t>(slot);
+        node.prev = kNil;
+        node.next = heads_[slot];
+        if (node.next != kNil) nodes_[node.next].prev = index;
+        heads_[slot] = index;
+    }
+
+    void unlink(uint32_t index) {
+        Node& node = nodes_[index];
+        if (node.prev != kNil) {
+            nodes_[node.prev].next = node.next;
+        } else {
+            heads_[node.slot] = node.next;
+        }
+        if (node.next != kNil) nodes_[node.next].prev = node.prev;
+        node.slot = kNil;
+    }
+
+    // 取下整个槽位的链表，返回表头
+    uint32_t detach(size_t slot) {
+        uint32_t head = heads_[slot];
+        heads_[slot] = kNil;
+        return head;
+    }
+
+    // 把高层槽位中的定时器按新的差值重新放置（逐级下放）；返回该层的槽位下标
+    size_t cascade(size_t level) {
+        size_t index = (current_ >> (level * kSlotBits)) & (kSlots - 1);
+        for (uint32_t i = detach(level * kSlots + index); i != kNil;) {
+            uint32_t next = nodes_[i].next;
+            place(i);
+            i = next;
+        }
+        return index;
+    }
+
+    // 处理刻度 current_：需要时先从高层下放，再触发第 0 层对应槽位中的全部定时器
+    void processTick(std::vector<Task>& fired) {
+        if ((current_ & (kSlots - 1)) == 0) {
+            for (size_t level = 1; level < kLevels && cascade(level) == 0; ++level) {
+            }
+        }
+        for (uint32_t i = detach(current_ & (kSlots - 1)); i != kNil;) {
+            Node& node = nodes_[i];
+            uint32_t next = node.next;
+            node.slot = kNil;
+            if (node.expires > current_) {
+                place(i);           // 超出最大范围的定时器：还没到期，继续等待
+            } else if (node.period == 0) {
+                fired.push_back(std::move(node.task));
+                release(i);
+            } else {
+                firePeriodic(node.periodic, fired);
+                node.expires = std::max(node.expires + node.period, current_ + 1);  // 追赶时不补发错过的触发
+                place(i);
+            }
+            i = next;
+        }
+        ++current_;
+    }
+
+    static void firePeriodic(const std::shared_ptr<Periodic>& periodic, std::vector<Task>& fired) {
+        if (periodic->running.exchange(true, std::memory_order_acquire)) return;   // 上一次还没执行完
+        fired.push_back([guard = RunningGuard(periodic)] { guard.periodic->fn(); });
+    }
+
+    // 第 0 层从 current_ 起的下一个非空槽位；没有时返回下一次逐级下放的刻度
+    // （current_ 恰好是 256 的倍数时，下放发生在 current_ 本身）
+    uint64_t nextEventTick() const {
+        uint64_t boundary = (current_ + kSlots - 1) & ~uint64_t(kSlots - 1);
+        for (uint64_t tick = current_; tick < boundary; ++tick) {
+            if (heads_[tick & (kSlots - 1)] != kNil) return tick;
+        }
+        return boundary;
+    }
+
+    uint64_t elapsedTicks(Clock::time_point now) const {
+        return now <= origin_ ? 0 : static_cast<uint64_t>((now - origin_) / tick_);
+    }
+
+    uint64_t tickAtOrAfter(Clock::time_point when) const {
+        if (when <= origin_) return 0;
+        auto ticks = (when - origin_ + tick_ - Clock::duration(1)) / tick_;   // 向上取整：不早于 when 触发
+        return static_cast<uint64_t>(ticks);
+    }
+
+    void run() {
+        std::vector<Task> fired;
+        std::unique_lock<std::mutex> lock(mtx_);
+        while (!stop_) {
+            uint64_t target = elapsedTicks(Clock::now());
+            while (current_ <= target && count_ > 0) processTick(fired);
+            if (count_ == 0) current_ = target + 1;
+
+            if (!fired.empty()) {
+                wakeTick_ = 0;      // 分发期间新插入的定时器不需要唤醒，分发后会重新检查
+                lock.unlock();
+                try {
+                    dispatch_(fired);   // 不持有锁：分发（入队）可能阻塞
+                } catch (...) {
+                    // 分发方拒绝（例如线程池已停止）：丢弃这批剩下的任务，定时线程继续运行；
+                    // 被丢弃的周期任务由 RunningGuard 清除 running，下一个周期照常触发
+                }
+                fired.clear();
+                lock.lock();
+                continue;
+            }
+            if (count_ == 0) {
+                wakeTick_ = UINT64_MAX;
+                cv_.wait(lock);
+            } else {
+                wakeTick_ = nextEventTick();
+                cv_.wait_until(lock, origin_ + tick_ * static_cast<Clock::rep>(wakeTick_));
+            }
+            wakeTick_ = 0;
+        }
+    }
+
+    Clock::duration tick_;
+    Dispatch dispatch_;
+    Clock::time_point origin_;                       // 刻度 0 对应的时刻
+    uint64_t current_;                               // 下一个要处理的刻度
+    uint64_t wakeTick_;                              // 定时线程计划醒来的刻度（休眠时有效）
+    size_t count_;
+    std::vector<Node> nodes_;
+    uint32_t freeHead_;
+    std::array<uint32_t, kLevels * kSlots> heads_;   // 各槽位链表的表头
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    std::thread worker_;
+    bool stop_;
+};
+
+#endif // TIMER_WHEEL_H
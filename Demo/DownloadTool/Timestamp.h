@@ -0,0 +1,68 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+/*
+ **************** 时间戳格式化（TimestampCache） ****************
+ 设计目标：
+    1. 把纳秒时间戳格式化为本地时间 "YYYY-mm-dd HH:MM:SS.uuuuuu"，精确到微秒
+    2. 日期和时分秒部分按秒缓存：同一秒内只用算术改写末尾 6 位微秒数字，不调用 localtime / strftime
+    3. 跨秒时用 localtime_r 重新计算（可重入；夏令时切换同样正确），不使用共享静态缓冲区的 localtime
+    4. 实例不加锁，只供一个线程使用；多个线程需要时各自持有一个（如 thread_local）
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <string>
+
+class TimestampCache {
+public:
+    static constexpr size_t kLength = 26;   // "YYYY-mm-dd HH:MM:SS.uuuuuu"
+
+    // 格式化到 out（至少 kLength 字节，不写结尾 '\0'），返回写入的字节数
+    size_t format(int64_t timeNs, char* out) {
+        int64_t second = timeNs / 1000000000;
+        int64_t subNs = timeNs % 1000000000;
+        if (subNs < 0) {                    // 1970 年以前：向下取整
+            --second;
+            subNs += 1000000000;
+        }
+        if (second != cachedSecond_) {
+            refresh(second);
+        }
+        std::memcpy(out, prefix_, kPrefixLength);
+        out[kPrefixLength] = '.';
+        uint32_t micros = static_cast<uint32_t>(subNs / 1000);
+        for (size_t i = kLength - 1; i > kPrefixLength; --i) {
+            out[i] = static_cast<char>('0' + micros % 10);
+            micros /= 10;
+        }
+        return kLength;
+    }
+
+    void append(std::string& out, int64_t timeNs) {
+        char buf[kLength];
+        out.append(buf, format(timeNs, buf));
+    }
+
+private:
+    static constexpr size_t kPrefixLength = 19;     // "YYYY-mm-dd HH:MM:SS"
+
+    void refresh(int64_t second) {
+        std::time_t time = static_cast<std::time_t>(second);
+        std::tm tm{};
+        char buf[kPrefixLength + 1];
+        if (!localtime_r(&time, &tm) || std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm) != kPrefixLength) {
+            std::memcpy(buf, "0000-00-00 00:00:00", kPrefixLength);     // 超出可表示范围
+        }
+        std::memcpy(prefix_, buf, kPrefixLength);
+        cachedSecond_ = second;
+    }
+
+    int64_t cachedSecond_ = std::numeric_limits<int64_t>::min();
+    char prefix_[kPrefixLength];
+};
+
+#endif // TIMESTAMP_H
@@ -0,0 +1,168 @@
+/*
+ **************** 日志前端微基准 ****************
+ 测量 log() 在调用线程上的耗时（ns/次），生产者线程数为 1 / 4 / 16：
+    - legacy：原 Logger::log 的做法，stringstream + put_time 格式化成 std::string，
+      在全局互斥锁下放入 std::queue，写入线程批量取出写文件
+    - ring：当前 Logger，每个线程一个定长记录的 SPSC 环，不分配内存、不取共享锁
+    - LOG_FMT：同一条消息走延迟格式化，调用方只编码格式串 ID 和参数
+ 最后比较同一条 LOG_FMT 消息在文本文件和二进制文件（.nlog）中每行占用的字节数
+ 每个线程每次连续写 kBurst 条（小于环容量），两次之间停顿 kPause 让写入线程排空，
+ 只统计 log() 调用本身消耗的线程 CPU 时间（CLOCK_THREAD_CPUTIME_ID，不含被抢占的时间，
+ 核数少于线程数时结果仍有意义），即热路径开销；写入线程的吞吐不在本基准的测量范围内
+ 编译：g++ -std=c++17 -O2 -pthread bench_logger.cpp -o bench_logger
+ 运行：./bench_logger [每线程条数] [日志目录]
+*/
+
+#include "Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <time.h>
+
+static constexpr size_t kBurst = 512;
+static constexpr std::chrono::milliseconds kPause{2};
+
+// 原实现的前端，作为对照组
+class LegacyLogger {
+public:
+    explicit LegacyLogger(const std::string& path) : file_(path, std::ios::trunc), writer_([this] { writerLoop(); }) {}
+
+    ~LegacyLogger() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        writer_.join();
+    }
+
+    void log(Logger::Level level, const std::string& message) {
+        std::string entry = formatLogEntry(level, message);
+        std::lock_guard<std::mutex> lock(mtx_);
+        buffer_.push(entry);
+        if (buffer_.size() >= 100) cv_.notify_one();
+    }
+
+private:
+    std::string formatLogEntry(Logger::Level level, const std::string& message) {
+        static const std::string levelStr[] = {"DEFAULT", "DEBUG", "INFO", "WARNING", "ERROR"};
+        auto now = std::chrono::system_clock::now();
+        auto time = std::chrono::system_clock::to_time_t(now);
+        std::stringstream ss;
+        ss << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S") << " [" << levelStr[static_cast<int>(level)]
+           << "] " << message;
+        return ss.str();
+    }
+
+    void writerLoop() {
+        std::unique_lock<std::mutex> lock(mtx_);
+        while (true) {
+            cv_.wait_for(lock, std::chrono::milliseconds(50), [this] { return stop_ || buffer_.size() >= 100; });
+            while (!buffer_.empty()) {
+                file_ << buffer_.front() << '\n';
+                buffer_.pop();
+            }
+            if (stop_) return;
+        }
+    }
+
+    std::ofstream file_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::queue<std::string> buffer_;
+    bool stop_ = false;
+    std::thread writer_;
+};
+
+static int64_t threadCpuNs() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// 每个线程写 perThread 条，返回平均每次 log() 的耗时（ns）
+template<typename LogFn>
+double measure(size_t threads, size_t perThread, LogFn log) {
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<double> nsPerCall(threads);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            ready.fetch_add(1);
+            while (!go.load()) std::this_thread::yield();
+            int64_t busy = 0;
+            for (size_t done = 0; done < perThread;) {
+                size_t n = std::min(kBurst, perThread - done);
+                int64_t start = threadCpuNs();
+                for (size_t i = 0; i < n; ++i) log(t, done + i);
+                busy += threadCpuNs() - start;
+                done += n;
+                std::this_thread::sleep_for(kPause);
+            }
+            nsPerCall[t] = static_cast<double>(busy) / perThread;
+        });
+    }
+    while (ready.load() < threads) std::this_thread::yield();
+    go.store(true);
+    for (auto& w : workers) w.join();
+    double sum = 0;
+    for (double ns : nsPerCall) sum += ns;
+    return sum / threads;
+}
+
+int main(int argc, char** argv) {
+    size_t perThread = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    std::string dir = argc > 2 ? argv[2] : "bench_logs";
+    std::filesystem::create_directories(dir);
+    Logger& logger = Logger::getInstance(dir, Logger::Level::INFO, 64 * 1024 * 1024, 100, 100);
+
+    std::printf("%-8s %10s %10s %12s\n", "threads", "legacy ns", "ring ns", "LOG_FMT ns");
+    for (size_t threads : {1, 4, 16}) {
+        double legacyNs;
+        {
+            LegacyLogger legacy(dir + "/legacy.txt");
+            legacyNs = measure(threads, perThread, [&](size_t t, size_t i) {
+                legacy.log(Logger::Level::INFO, "Download progress: thread " + std::to_string(t) + ", chunk " +
+                                                    std::to_string(i) + ", 12.34 MB/s");
+            });
+        }
+        double ringNs = measure(threads, perThread, [&](size_t t, size_t i) {
+            // 与 legacy 相同的消息；拼接字符串的开销属于调用方，两边都算在内
+            logger.log(Logger::Level::INFO, "Download progress: thread " + std::to_string(t) + ", chunk " +
+                                                std::to_string(i) + ", 12.34 MB/s");
+        });
+        double ringLiteralNs = measure(threads, perThread, [&](size_t, size_t) {
+            logger.log(Logger::Level::INFO, "Download progress: chunk written, 12.34 MB/s");
+        });
+        double fmtNs = measure(threads, perThread, [&](size_t t, size_t i) {
+            LOG_FMT(Logger::Level::INFO, "Download progress: thread %zu, chunk %zu, %.2f MB/s", t, i, 12.34);
+        });
+        std::printf("%-8zu %10.1f %10.1f %12.1f   (字面量消息 %.1f ns)\n", threads, legacyNs, ringNs, fmtNs,
+                    ringLiteralNs);
+    }
+
+    // 每行字节数：用 AsyncIO 统计的写入字节数之差计算
+    auto bytesPerLine = [&](Logger::Output output) {
+        logger.setOutput(output);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200)); // 等写入线程切换文件并排空之前的日志
+        uint64_t before = logger.ioStats().bytesWritten;
+        measure(1, perThread, [&](size_t t, size_t i) {
+            LOG_FMT(Logger::Level::INFO, "Download progress: thread %zu, chunk %zu, %.2f MB/s", t, i, 12.34);
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        return static_cast<double>(logger.ioStats().bytesWritten - before) / perThread;
+    };
+    double textBytes = bytesPerLine(Logger::Output::Text);
+    double binaryBytes = bytesPerLine(Logger::Output::Binary);
+    std::printf("每行字节数：文本 %.1f，二进制 %.1f（%.1f 倍）\n", textBytes, binaryBytes, textBytes / binaryBytes);
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ **************** 任务提交微基准 ****************
+ 对比两种任务表示的吞吐量与每个任务的堆分配次数：
+    - legacy：make_shared<packaged_task> + std::bind + std::function（原 ThreadPool::enqueue 的做法）
+    - unique：UniqueFunction + PromiseTask + RecyclingAllocator（当前 ThreadPool::enqueue）
+ 编译：g++ -std=c++17 -O2 -pthread bench_task.cpp -o bench_task
+ 运行：./bench_task [任务数] [线程数]
+*/
+
+#include "ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <new>
+#include <queue>
+
+// 统计全局 operator new 调用次数。普通、数组、对齐三种形式一起替换，
+// 保证每种 new 都和同一组 malloc/free 实现的 delete 配对
+static std::atomic<size_t> g_allocations{0};
+
+static void* countedAlloc(size_t size, size_t alignment = 0) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    void* p = alignment > alignof(std::max_align_t)
+        ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)   // 大小须为对齐的整数倍
+        : std::malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void* operator new(size_t size, std::align_val_t al) { return countedAlloc(size, static_cast<size_t>(al)); }
+void* operator new[](size_t size, std::align_val_t al) { return countedAlloc(size, static_cast<size_t>(al)); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+// 原始实现，作为对照组
+class LegacyThreadPool {
+public:
+    LegacyThreadPool(size_t numThreads) : stop_(false) {
+        for (size_t i = 0; i < numThreads; ++i) {
+            workers_.emplace_back([this] {
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(mtx_);
+                        cv_.wait(lock, [this] {return stop_ || !tasks_.empty(); });
+                        if (stop_ && tasks_.empty()) return;
+                        task = std::move(tasks_.front());
+                        tasks_.pop();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+
+    ~LegacyThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& worker : workers_) worker.join();
+    }
+
+    template<typename F, typename... Args>
+    auto enqueue(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
+        using ReturnType = std::invoke_result_t<F, Args...>;
+        auto task = std::make_shared<std::packaged_task<ReturnType()>>(
+            std::bind(std::forward<F>(f), std::forward<Args>(args)...)
+        );
+        std::future<ReturnType> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (stop_) throw std::runtime_error("Enqueue on stopped thread pool");
+            tasks_.emplace([task] {(*task)(); });
+        }
+        cv_.notify_all();
+        return result;
+    }
+
+private:
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool stop_;
+};
+
+// 以固定的在途任务窗口提交（每批 kWindow 个，等待完成后再提交下一批），模拟稳定的流水线负载
+constexpr size_t kWindow = 1024;
+
+template<typename Pool>
+long long submitAll(Pool& pool, size_t numTasks, std::vector<std::future<int>>& futures) {
+    long long sum = 0;
+    for (size_t base = 0; base < numTasks; base += kWindow) {
+        size_t end = std::min(numTasks, base + kWindow);
+        for (size_t i = base; i < end; ++i) {
+            futures.push_back(pool.enqueue([i] { return static_cast<int>(i); }));
+        }
+        for (auto& f : futures) sum += f.get();
+        futures.clear();
+    }
+    return sum;
+}
+
+template<typename Pool>
+void run(const char* name, size_t numTasks, size_t numThreads) {
+    Pool pool(numThreads);
+    std::vector<std::future<int>> futures;
+    futures.reserve(kWindow);
+
+    // 预热一轮，让任务队列与空闲链表达到稳定状态
+    submitAll(pool, kWindow * 4, futures);
+
+    size_t allocsBefore = g_allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    long long sum = submitAll(pool, numTasks, futures);
+    auto end = std::chrono::steady_clock::now();
+    size_t allocs = g_allocations.load() - allocsBefore;
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::printf("%-8s threads=%zu tasks=%zu  %.0f tasks/s  %.2f allocs/task  (checksum %lld)\n",
+                name, numThreads, numTasks, numTasks / seconds,
+                static_cast<double>(allocs) / numTasks, sum);
+}
+
+int main(int argc, char** argv) {
+    size_t numTasks = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    size_t numThreads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4;
+
+    run<LegacyThreadPool>("legacy", numTasks, numThreads);
+    run<ThreadPool>("unique", numTasks, numThreads);
+    return 0;
+}
@@ -0,0 +1,38 @@
+/*
+ **************** 二进制日志解码工具 ****************
+ 把 Logger 以 Output::Binary 写出的 .nlog 文件还原为与文本日志相同格式的文本，输出到标准输出
+ 编译：g++ -std=c++17 -O2 log_decoder.cpp -o log_decoder
+ 运行：./log_decoder logs/log_20240101_120000_000.nlog [更多文件...]
+*/
+
+#include "BinaryLog.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "用法：%s <file.nlog>...\n", argv[0]);
+        return 2;
+    }
+    int status = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file) {
+            std::fprintf(stderr, "%s: 无法打开\n", argv[i]);
+            status = 1;
+            continue;
+        }
+        std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        bool ok = binlog::decodeFile(data, [](std::string_view line) {
+            std::fwrite(line.data(), 1, line.size(), stdout);
+            std::fputc('\n', stdout);
+        });
+        if (!ok) {
+            std::fprintf(stderr, "%s: 不是二进制日志文件或内容被截断\n", argv[i]);
+            status = 1;
+        }
+    }
+    return status;
+}
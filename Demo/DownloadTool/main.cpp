@@ -1,4 +1,5 @@
 #include "ThreadPool.h"
+#include "PoolMetrics.h"
 #include "Logger.h"
 #include "DownloadTool.h"
 #include <iostream>
@@ -50,16 +51,21 @@ int main() {
         Logger::getInstance("logs", Logger::Level::INFO);
         Logger::getInstance().log(Logger::Level::INFO, "下载工具启动");
         
+        // 写盘用独立的小线程池：退化为 pwrite 时的写操作和完成回调都在这里执行，不占用 curl 回调线程；
+        // 不能用下面的下载线程池，下载任务会阻塞等待这些回调。先于 pool 声明，pool 的任务结束后才析构
+        ThreadPool ioPool(2);
+        AsyncIO io(ioPool.executor());
+
         ThreadPool pool(4);
         Logger::getInstance().log(Logger::Level::INFO, "线程池初始化完成 (4线程)");
+        startStatsDump(pool, std::chrono::seconds(10));     // 每 10 秒把线程池指标写入日志
 
-        // 创建下载工具实例和进度条观察者
-        auto downloader = std::make_shared<DownloadTool>();
+        // 进度条观察者；每个下载任务各自创建 DownloadTool（curl 句柄不能在线程间共享）
         auto progressObserver = std::make_shared<ProgressBarObserver>();
-        downloader->addObserver(progressObserver);
+        StopSource shutdown;    // 退出时取消所有排队中和进行中的下载
         
         std::string command;
-        std::vector<std::future<DownloadTool::DownloadResult>> activeTasks;
+        std::vector<Future<void>> activeTasks;  // 每个下载及其后续记录日志的整条链路
         
         std::cout << "====== 命令行下载工具 ======" << std::endl;
         std::cout << "输入URL开始下载 (输入'quit'退出)" << std::endl;
@@ -69,7 +75,7 @@ int main() {
             activeTasks.erase(
                 std::remove_if(activeTasks.begin(), activeTasks.end(),
                     [](const auto& task) { 
-                        return task.wait_for(std::chrono::seconds(0)) == std::future_status::ready; 
+                        return task.ready(); 
                     }),
                 activeTasks.end()
             );
@@ -97,8 +103,29 @@ int main() {
                     Logger::getInstance().log(Logger::Level::INFO, "提交下载任务: " + url);
                     std::cout << "正在准备下载..." << std::endl;
                     
-                    activeTasks.push_back(pool.enqueue([downloader, url, outputFile]() {
-                        return downloader->download(url, outputFile);
+                    // 下载完成后由线程池运行后续的日志记录，不需要任何线程阻塞在 get() 上
+                    activeTasks.push_back(pool.async(shutdown.get_token(),
+                        [progressObserver, url, outputFile, &io](StopToken token) {
+                        DownloadTool downloader(io);
+                        downloader.addObserver(progressObserver);
+                        return downloader.download(url, outputFile, std::move(token));
+                    }).then([](DownloadTool::DownloadResult result) {
+                        if (result.cancelled) {
+                            Logger::getInstance().log(Logger::Level::INFO, "任务已取消: " + result.error);
+                        } else if (result.success) {
+                            Logger::getInstance().log(
+                                Logger::Level::INFO, 
+                                "任务成功完成: " + std::to_string(result.bytesDownloaded) + " 字节"
+                            );
+                        }
+                    }).recover([](std::exception_ptr error) {
+                        try {
+                            std::rethrow_exception(error);
+                        } catch (const TaskCancelledError&) {
+                            Logger::getInstance().log(Logger::Level::INFO, "任务在开始前被取消");
+                        } catch (const std::exception& e) {
+                            Logger::getInstance().log(Logger::Level::ERROR, "任务异常: " + std::string(e.what()));
+                        }
                     }));
                 } catch (const std::exception& e) {
                     std::cerr << "提交任务失败: " << e.what() << std::endl;
@@ -107,21 +134,10 @@ int main() {
             }
         }
         
-        // 等待所有活跃的下载任务完成
-        std::cout << "等待所有下载任务完成..." << std::endl;
-        for (auto& task : activeTasks) {
-            try {
-                auto result = task.get();
-                if (result.success) {
-                    Logger::getInstance().log(
-                        Logger::Level::INFO, 
-                        "任务成功完成: " + std::to_string(result.bytesDownloaded) + " 字节"
-                    );
-                }
-            } catch (const std::exception& e) {
-                Logger::getInstance().log(Logger::Level::ERROR, "任务异常: " + std::string(e.what()));
-            }
-        }
+        // 取消所有下载：排队中的任务不再运行，进行中的传输在下一次进度回调时中止
+        std::cout << "正在取消未完成的下载任务..." << std::endl;
+        shutdown.request_stop();
+        when_all(std::move(activeTasks)).get();
         
     } catch (const std::exception& e) {
         std::cerr << "程序错误: " << e.what() << std::endl;
@@ -0,0 +1,246 @@
+/*
+ **************** 调度组件回归测试 ****************
+ 覆盖评审中发现的失败路径，每一项失败时打印原因并以非 0 退出：
+    - 周期定时器：某次触发抛出异常、或某次触发被分发方拒绝后，下一个周期仍然触发
+    - 队列已满且策略为 CallerRuns 时，到期任务仍由工作线程执行，定时线程不执行用户代码
+    - Strand / KeyedExecutor：任务抛出异常后，之后提交到同一个 Strand / key 的任务仍然执行
+    - Strand 排空一轮后让出工作线程：续作排在外部已提交的任务之后，而不是进入本线程的本地槽位
+    - AsyncIO 退化为 pwrite 且设置 fallbackThread 时，写操作在它自己的写线程上执行，不占用提交线程
+    - then() 的任务被执行器拒绝（线程池已停止 / FailFast 队列已满）时，下游以拒绝的异常完成，而不是 broken_promise
+ 编译：g++ -std=c++17 -O2 -pthread test_scheduling.cpp -o test_scheduling
+ 运行：./test_scheduling
+*/
+
+#include "AsyncIO.h"
+#include "Strand.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+static int g_failures = 0;
+
+static void check(bool ok, const char* what) {
+    std::printf("%-60s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) ++g_failures;
+}
+
+// 等待 done() 成立，最多 timeout
+template<typename Done>
+static bool waitFor(Done&& done, std::chrono::milliseconds timeout = 2000ms) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!done()) {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+// 周期任务第一次触发时抛出异常，之后仍应继续触发
+static void testThrowingPeriodic() {
+    ThreadPool pool(2);
+    std::atomic<int> calls{0};
+    TimerHandle handle = pool.schedule_every(2ms, [&calls] {
+        if (calls.fetch_add(1) == 0) throw std::runtime_error("first tick fails");
+    });
+    check(waitFor([&] { return calls.load() >= 3; }), "periodic timer keeps firing after it throws");
+    pool.cancel_timer(handle);
+}
+
+// 分发方拒绝第一批到期任务（任务没有执行就被销毁），周期任务之后仍应继续触发
+static void testRejectedPeriodic() {
+    std::atomic<int> dispatches{0};
+    std::atomic<int> calls{0};
+    TimerWheel wheel(1ms, [&dispatches](std::vector<TimerWheel::Task>& batch) {
+        if (dispatches.fetch_add(1) == 0) throw std::runtime_error("rejected");
+        for (auto& task : batch) task();
+    });
+    wheel.schedule_periodic(TimerWheel::Clock::now() + 2ms, 2ms, [&calls] { calls.fetch_add(1); });
+    check(waitFor([&] { return calls.load() >= 2; }), "periodic timer keeps firing after a rejected dispatch");
+    wheel.stop();
+}
+
+// 唯一的工作线程被占住、队列已满时到期的定时任务：等到空位后由工作线程执行
+static void testTimerOverflowUsesWorkers() {
+    ThreadPool::Options options;
+    options.coreThreads = options.maxThreads = 1;
+    options.queueCapacity = 2;
+    options.rejectPolicy = ThreadPool::RejectPolicy::CallerRuns;
+    ThreadPool pool(options);
+    std::atomic<bool> release{false};
+    std::atomic<std::thread::id> worker{};
+    pool.post([&] {
+        worker = std::this_thread::get_id();
+        while (!release) std::this_thread::sleep_for(1ms);
+    });
+    while (worker.load() == std::thread::id()) std::this_thread::yield();
+    for (int i = 0; i < 2; ++i) pool.post([] {});       // 填满队列
+    std::atomic<int> fired{0};
+    std::atomic<int> offWorker{0};
+    for (int i = 0; i < 4; ++i) {
+        pool.schedule_after(1ms, [&] {
+            if (std::this_thread::get_id() != worker.load()) offWorker.fetch_add(1);
+            fired.fetch_add(1);
+        });
+    }
+    std::this_thread::sleep_for(20ms);
+    bool heldBack = fired.load() == 0;
+    release = true;
+    check(waitFor([&] { return fired.load() == 4; }) && heldBack && offWorker.load() == 0,
+          "timer overflow waits for space instead of running on the timer thread");
+}
+
+// 工作线程被占住时排队若干任务，其中第一个抛出异常；之后提交的任务仍应按顺序执行
+static void testThrowingStrandTask() {
+    ThreadPool pool(2);
+    Strand strand(pool);
+    std::atomic<int> ran{0};
+    strand.post([] { throw std::runtime_error("strand task fails"); });
+    for (int i = 0; i < 3; ++i) strand.post([&ran] { ran.fetch_add(1); });
+    bool firstBatch = waitFor([&] { return ran.load() == 3; });
+    strand.post([] { throw std::runtime_error("strand task fails again"); });
+    strand.post([&ran] { ran.fetch_add(1); });
+    check(firstBatch && waitFor([&] { return ran.load() == 4; }) && strand.task_exceptions() == 2,
+          "strand keeps running tasks after one throws");
+}
+
+// 同一个 key 上的任务抛出异常后：key 的状态照常释放，之后同一个 key 上的提交仍然执行
+static void testThrowingKeyedTask() {
+    ThreadPool pool(2);
+    KeyedExecutor<std::string> keyed(pool);
+    std::atomic<int> ran{0};
+    keyed.post("a", [] { throw std::runtime_error("keyed task fails"); });
+    keyed.post("a", [&ran] { ran.fetch_add(1); });
+    bool first = waitFor([&] { return ran.load() == 1 && keyed.active_keys() == 0; });
+    keyed.post("a", [] { throw std::runtime_error("keyed task fails again"); });
+    for (int i = 0; i < 3; ++i) keyed.post("a", [&ran] { ran.fetch_add(1); });
+    bool second = waitFor([&] { return ran.load() == 4 && keyed.active_keys() == 0; });
+    check(first && second && keyed.task_exceptions() == 2, "keyed executor keeps running a key after its task throws");
+}
+
+// 单工作线程：Strand 排队 kStrandBatch + 1 个任务，随后外部提交任务 other；
+// 排空一轮后续作应排到 other 之后，other 先于 Strand 的最后一个任务执行
+static void testStrandYieldsToGlobalQueue() {
+    ThreadPool::Options options;
+    options.coreThreads = options.maxThreads = 1;
+    ThreadPool pool(options);
+    Strand strand(pool);
+    std::atomic<bool> release{false};
+    std::atomic<bool> started{false};
+    pool.post([&] {
+        started = true;
+        while (!release) std::this_thread::sleep_for(1ms);
+    });
+    while (!started) std::this_thread::yield();
+    std::atomic<int> ran{0};
+    std::atomic<int> ranBeforeOther{-1};
+    for (size_t i = 0; i <= kStrandBatch; ++i) strand.post([&ran] { ran.fetch_add(1); });
+    pool.post([&] { ranBeforeOther = ran.load(); });
+    release = true;
+    check(waitFor([&] { return ran.load() == static_cast<int>(kStrandBatch) + 1; }) &&
+              waitFor([&] { return ranBeforeOther.load() >= 0; }) &&
+              ranBeforeOther.load() == static_cast<int>(kStrandBatch),
+          "strand continuation queues behind already submitted tasks");
+}
+
+// 强制 pwrite 后端、没有执行器：写操作和回调由 AsyncIO 的写线程执行，数据完整写入
+static void testFallbackWriterThread() {
+    char path[] = "/tmp/test_scheduling_XXXXXX";
+    int fd = ::mkstemp(path);
+    if (fd < 0) {
+        check(false, "AsyncIO fallback writes run on its own writer thread");
+        return;
+    }
+    ::unlink(path);
+    const std::thread::id caller = std::this_thread::get_id();
+    std::atomic<int> offCaller{0};
+    std::atomic<int> written{0};
+    {
+        AsyncIO::Options options;
+        options.forceFallback = true;
+        options.fallbackThread = true;
+        AsyncIO io(Executor{}, options);
+        for (int i = 0; i < 8; ++i) {
+            io.write(fd, std::string(1000, static_cast<char>('a' + i)), i * 1000, [&](ssize_t n) {
+                if (std::this_thread::get_id() != caller) offCaller.fetch_add(1);
+                if (n == 1000) written.fetch_add(1);
+            });
+        }
+        io.submit();
+        io.drain();
+    }
+    char last = 0;
+    bool contentOk = ::pread(fd, &last, 1, 7999) == 1 && last == 'h';
+    ::close(fd);
+    check(offCaller.load() == 8 && written.load() == 8 && contentOk, "AsyncIO fallback writes run on its own writer thread");
+}
+
+// 返回 future 以 E 失败时的异常消息，其他结果返回空串
+template<typename E, typename T>
+static std::string failureOf(Future<T>& future) {
+    try {
+        future.get();
+    } catch (const E& e) {
+        return e.what();
+    } catch (...) {
+    }
+    return {};
+}
+
+// then() 提交续作失败：执行器先取得任务再抛出（与 ThreadPool::post 一致），下游应以该异常完成
+static void testRejectedContinuation() {
+    // 与已停止的线程池相同的行为：任务在 post 内构造后随异常一起销毁
+    Executor stopped{nullptr, [](void*, ThreadPool::Task&& task) {
+        ThreadPool::Task taken(std::move(task));
+        throw std::runtime_error("Enqueue on stopped thread pool");
+    }};
+    Promise<int> upstream;
+    Future<int> onStopped = upstream.get_future().then(stopped, [](int v) { return v + 1; });
+    upstream.set_value(1);
+    check(failureOf<std::runtime_error>(onStopped) == "Enqueue on stopped thread pool",
+          "then() on a stopped executor fails with the submit error");
+
+    // 真实的线程池：唯一的工作线程被占住、队列已满且策略为 FailFast
+    ThreadPool::Options options;
+    options.coreThreads = options.maxThreads = 1;
+    options.queueCapacity = 2;
+    options.rejectPolicy = ThreadPool::RejectPolicy::FailFast;
+    ThreadPool pool(options);
+    std::atomic<bool> release{false};
+    std::atomic<bool> started{false};
+    pool.post([&] {
+        started = true;
+        while (!release) std::this_thread::sleep_for(1ms);
+    });
+    while (!started) std::this_thread::yield();
+    for (int i = 0; i < 2; ++i) pool.post([] {});
+    Promise<int> full;
+    Future<int> onFull = full.get_future().then(pool.executor(), [](int v) { return v + 1; });
+    full.set_value(1);
+    release = true;
+    check(!failureOf<QueueFullError>(onFull).empty(), "then() on a full FailFast pool fails with QueueFullError");
+}
+
+int main() {
+    testThrowingPeriodic();
+    testRejectedPeriodic();
+    testTimerOverflowUsesWorkers();
+    testThrowingStrandTask();
+    testThrowingKeyedTask();
+    testStrandYieldsToGlobalQueue();
+    testFallbackWriterThread();
+    testRejectedContinuation();
+    if (g_failures) {
+        std::printf("%d check(s) failed\n", g_failures);
+        return EXIT_FAILURE;
+    }
+    std::puts("all checks passed");
+    return EXIT_SUCCESS;
+}
@@ -5,17 +5,24 @@
 #include <mutex>
 #include <thread>
 #include <condition_variable>
+#include <algorithm>
+#include "Topology.h"
 
 class ThreadPool {
 public:
-    ThreadPool(size_t num_threads) {
+    // affinity 指定绑核方式（默认不绑核），例如 CpuAffinity::topology() 或 CpuAffinity::list("0-3")
+    ThreadPool(size_t num_threads, const CpuAffinity& affinity = CpuAffinity::none()) {
+        std::vector<int> cpus = affinity.resolve(num_threads);
         for (size_t i = 0; i < num_threads; ++i) {
-            workers.emplace_back([this] {
+            workers.emplace_back([this, cpu = cpus[i]] {
+                if (cpu >= 0) Topology::pinCurrentThread(cpu);
                 while (true) {
                     std::function<void()> task;
                     {
                         std::unique_lock<std::mutex> lock(tasks_mutex);
+                        ++idle;
                         condition.wait(lock, [this] {return stop || !tasks.empty();});
+                        --idle;
                         if (stop && tasks.empty()) return;
                         task = std::move(tasks.front());
                         tasks.pop();
@@ -38,20 +45,42 @@ public:
         }
     }
 
+    // 没有空闲线程时不通知：忙碌的线程执行完当前任务后会直接取走它
     void submit(std::function<void()> task) {
+        bool wake = false;
         {
             std::unique_lock<std::mutex> lock(tasks_mutex);
             tasks.push(std::move(task));
+            wake = idle > 0;
+        }
+        if (wake) {
+            condition.notify_one();
         }
-        condition.notify_one();
     }
 
+    // 批量提交：一次加锁插入 [first, last) 中的全部任务，只唤醒 min(任务数, 空闲线程数) 个线程
+    template<typename InputIt>
+    void submit_range(InputIt first, InputIt last) {
+        size_t count = 0;
+        size_t wake = 0;
+        {
+            std::unique_lock<std::mutex> lock(tasks_mutex);
+            for (; first != last; ++first, ++count) {
+                tasks.push(std::function<void()>(*first));
+            }
+            wake = std::min(count, idle);
+        }
+        for (size_t i = 0; i < wake; ++i) {
+            condition.notify_one();
+        }
+    }
 
 private:
     std::vector<std::thread> workers;
     std::queue<std::function<void()>> tasks;
     std::mutex tasks_mutex;
     std::condition_variable condition;
+    size_t idle = 0;    // 正在等待任务的线程数（受 tasks_mutex 保护）
     bool stop = false;
 };
 
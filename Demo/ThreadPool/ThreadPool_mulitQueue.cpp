@@ -6,7 +6,23 @@
 #include<vector>
 #include<queue>
 #include<future>
-#include<random>
+#include<atomic>
+#include<cstdint>
+#include<memory>
+#include<stdexcept>
+#include<type_traits>
+
+/*
+ **************** 多队列线程池 ****************
+    1. 每个工作线程一个带锁的本地队列，提交方只锁其中一个队列，各队列之间没有竞争
+    2. 投递采用"二选一"（power of two choices）：随机挑两个队列，放入负载较小的一个；
+       负载 = 排队任务数 + 正在执行的任务数（近似值，无锁读取），任务耗时不均时也能保持均衡
+    3. 随机数来自每个线程自己的 xorshift 状态，不再使用带全局锁的 std::rand()
+    4. 本地队列为空时依次尝试从兄弟队列头部取任务（try_lock，不与对方的提交争锁）；
+       仍然没有任务时登记为空闲，在自己的条件变量上休眠，不做定时轮询
+    5. 提交方放入任务后，若有空闲线程则唤醒其中一个（优先目标队列的所有者），由它去取兄弟队列中的任务；
+       没有空闲线程时不做任何通知
+*/
 class ThreadPool{
     private:
         struct localQueue
@@ -14,61 +30,153 @@ class ThreadPool{
             std::mutex mtx;
             std::condition_variable cv;
             std::queue<std::function<void()>> tasks;
+            std::atomic<size_t> load{0};//排队 + 正在执行的任务数
+            std::atomic<bool> idle{false};//所有者线程在 cv 上休眠，等待被唤醒（修改时持有 mtx）
         };
 
         std::vector<std::thread> workers;//工作线程
         std::vector<localQueue> tasksQueue;//任务队列
         int localSize;//线程数量
-        bool stop;//停止符号
-    
+        std::atomic<bool> stop;//停止符号
+        std::atomic<size_t> pending{0};//所有队列中排队（尚未取出）的任务数
+        std::atomic<int> idleCount{0};//休眠中的线程数，提交方据此决定是否需要唤醒
+
+        static int checkedSize(int num){
+            if(num <= 0) throw std::invalid_argument("ThreadPool needs at least one worker");
+            return num;
+        }
+
+        // 每个线程独立的 xorshift64 随机数，首次使用时用线程地址播种
+        static uint64_t nextRandom(){
+            static thread_local uint64_t state = 0;
+            if(state == 0){
+                int local = 0;
+                state = reinterpret_cast<uintptr_t>(&local) * 0x9E3779B97F4A7C15ull | 1;
+            }
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return state;
+        }
+
+        // 二选一：两个随机队列中负载较小的一个
+        int pickQueue(){
+            if(localSize == 1) return 0;
+            uint64_t r = nextRandom();
+            int a = static_cast<int>((r & 0xFFFFFFFF) % localSize);
+            int b = static_cast<int>((r >> 32) % (localSize - 1));
+            if(b >= a) b++;//保证 b != a
+            size_t loadA = tasksQueue[a].load.load(std::memory_order_relaxed);
+            size_t loadB = tasksQueue[b].load.load(std::memory_order_relaxed);
+            return loadB < loadA ? b : a;
+        }
+
+        // 从队列 q 头部取一个任务；wait 为 false 时只 try_lock，拿不到锁直接放弃
+        bool tryPop(localQueue& q, std::function<void()>& task, bool wait){
+            std::unique_lock<std::mutex> lock(q.mtx, std::defer_lock);
+            if(wait){
+                lock.lock();
+            }else if(!lock.try_lock()){
+                return false;
+            }
+            if(q.tasks.empty()) return false;
+            task = std::move(q.tasks.front());
+            q.tasks.pop();
+            pending.fetch_sub(1);
+            return true;
+        }
+
+        // 先取自己的队列，再从 i + 1 开始依次尝试兄弟队列；返回任务所在的队列序号，没有任务返回 -1
+        int findTask(int i, std::function<void()>& task){
+            if(tryPop(tasksQueue[i], task, true)) return i;
+            for(int k = 1;k < localSize;k++){
+                int j = (i + k) % localSize;
+                if(tasksQueue[j].load.load(std::memory_order_relaxed) == 0) continue;
+                if(tryPop(tasksQueue[j], task, false)) return j;
+            }
+            return -1;
+        }
+
+        // 唤醒一个空闲线程，从队列 index 的所有者开始找
+        void wakeOne(int index){
+            for(int k = 0;k < localSize;k++){
+                localQueue& q = tasksQueue[(index + k) % localSize];
+                if(!q.idle.load(std::memory_order_relaxed)) continue;
+                {
+                    std::lock_guard<std::mutex> lock(q.mtx);
+                    if(!q.idle.load(std::memory_order_relaxed)) continue;
+                    q.idle.store(false, std::memory_order_relaxed);
+                    idleCount.fetch_sub(1);
+                }
+                q.cv.notify_one();
+                return;
+            }
+        }
+
+        void workerLoop(int i){
+            localQueue& own = tasksQueue[i];
+            while(true){
+                std::function<void()> task;
+                int from = findTask(i, task);
+                if(from < 0){
+                    std::unique_lock<std::mutex> lock(own.mtx);
+                    if(stop && own.tasks.empty()){
+                        return;
+                    }
+                    // 先登记空闲再检查排队数：与提交方"先加排队数再看空闲数"配对，两边至少有一方看到对方
+                    own.idle.store(true, std::memory_order_relaxed);
+                    idleCount.fetch_add(1);
+                    if(pending.load() == 0){
+                        own.cv.wait(lock, [this,&own]{return stop || !own.idle.load(std::memory_order_relaxed);});
+                    }
+                    if(own.idle.load(std::memory_order_relaxed)){//没有被提交方唤醒（有任务在排队或正在停止）
+                        own.idle.store(false, std::memory_order_relaxed);
+                        idleCount.fetch_sub(1);
+                    }
+                    continue;//重新扫描：自己的队列或兄弟队列
+                }
+                task();
+                tasksQueue[from].load.fetch_sub(1, std::memory_order_relaxed);//执行完才减，负载包含正在执行的任务
+            }
+        }
+
     public:
-        ThreadPool(int num):stop(false),localSize(num){
+        ThreadPool(int num):tasksQueue(checkedSize(num)),localSize(num),stop(false){
             for(int i = 0;i < num;i++){
-                workers.emplace_back([this,i]{
-                    while (true)
-                    {
-                        std::function<void()> task;
-                        {
-                            std::unique_lock<std::mutex> lock(this->tasksQueue[i].mtx);
-                            tasksQueue[i].cv.wait(lock,[this,i]{return stop||!tasksQueue[i].tasks.empty();});
-                            if(stop && tasksQueue[i].tasks.empty()){
-                                return;
-                            }
-                            if(!tasksQueue[i].tasks.empty()){
-                                task = tasksQueue[i].tasks.front();
-                                tasksQueue[i].tasks.pop();
-                            }
-                        }
-                        task();
-                    }
-                    
-                })
-            ;}
-            
+                workers.emplace_back([this,i]{workerLoop(i);});
+            }
         }
 
         template<class F,class ...Args>
-        auto enqueue(F&&f,Args&&...args)->std::future<typename std::result_of<F(Args...)>::type>{
-            using return_type = typename std::result_of<F(Args...)>::type;
-            auto task = std::make_shared<::packaged_task<return_type()>>(
-                std::bind(std::forward<F>f, std::forward<Args>args...);
+        auto enqueue(F&&f,Args&&...args)->std::future<std::invoke_result_t<F, Args...>>{
+            using return_type = std::invoke_result_t<F, Args...>;
+            auto task = std::make_shared<std::packaged_task<return_type()>>(
+                std::bind(std::forward<F>(f), std::forward<Args>(args)...)
             );
             std::future<return_type> res = task->get_future();
             if (stop) {
                 throw std::runtime_error("enqueue on stopped ThreadPool");
             }
-            int index = std::rand() % localSize;
-            tasksQueue[index].tasks.push([this]{(*task)();});
-            tasksQueue[index].cv.notify_one();
+            int index = pickQueue();
+            tasksQueue[index].load.fetch_add(1, std::memory_order_relaxed);
+            pending.fetch_add(1);
+            {
+                std::unique_lock<std::mutex> lock(tasksQueue[index].mtx);
+                tasksQueue[index].tasks.push([task]{(*task)();});
+            }
+            if(idleCount.load() > 0){
+                wakeOne(index);
+            }
             return res;
-            
+
         }
 
         ~ThreadPool(){
 
             stop = true;
-            
+
             for(auto& q:tasksQueue){
+                { std::unique_lock<std::mutex> lock(q.mtx); }//确保正在进入等待的线程能看到 stop
                 q.cv.notify_all();
             }
 
@@ -76,4 +184,4 @@ class ThreadPool{
                 workers[i].join();
             }
         }
-};
\ No newline at end of file
+};
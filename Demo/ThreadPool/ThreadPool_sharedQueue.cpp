@@ -6,6 +6,7 @@
 #include<vector>
 #include<queue>
 #include<future>
+#include<type_traits>
 
 class ThreadPool{
     private:
@@ -38,17 +39,16 @@ class ThreadPool{
             }
         }
         template<class F,class ...Args>
-        auto enqueue(F&&f,Args&&...args)->std::future<typename std::result_of<F(Args...)>::type>{
-            using return_type = typename std::result_of<F(Args...)>::type;
-            return_type res;
+        auto enqueue(F&&f,Args&&...args)->std::future<std::invoke_result_t<F, Args...>>{
+            using return_type = std::invoke_result_t<F, Args...>;
 
             auto task = std::make_shared<std::packaged_task<return_type()>>(
-                bind(std::forward<F>f, std::forward<Arg...>args)
+                std::bind(std::forward<F>(f), std::forward<Args>(args)...)
             );
-            return_type res = task->get_future();
+            std::future<return_type> res = task->get_future();
             {
-                std::unique_lock<mutex> lock(this->mtx);
-                tasks.push([task]{(*task)()};);
+                std::unique_lock<std::mutex> lock(this->mtx);
+                tasks.push([task]{(*task)();});
             }
             cv.notify_one();
             
@@ -4,70 +4,276 @@
 #include<thread>
 #include<mutex>
 #include<condition_variable>
-#include<queue>
+#include<deque>
 #include<vector>
-#include<chrono>
+#include<memory>
+#include<atomic>
+#include<stdexcept>
+#include<type_traits>
+#include<algorithm>
+#include "WorkStealingDeque.h"
+#include "Topology.h"
+
+/*
+ **************** 工作窃取线程池 ****************
+    1. 每个工作线程拥有一个无锁 Chase-Lev 双端队列：自己在底部 push/pop，其他线程在顶部窃取
+    2. 外部线程提交的任务进入共享的注入队列（injector），工作线程内部提交的任务直接进入本地队列
+    3. 空闲线程先短暂自旋寻找任务，再在条件变量上休眠；提交任务时只有存在休眠线程才加锁唤醒
+    4. 可按 CPU 列表或检测到的拓扑绑核；窃取按由近到远的顺序：同一物理核 -> 同一 LLC -> 同一节点 -> 跨节点，
+       同一层内从随机位置开始；每个 NUMA 节点一个注入队列，任务可带节点提示（enqueue_on）放到数据附近
+*/
 class ThreadPool{
     private:
+        using Task = std::function<void()>;
+
         struct localQueue
         {
-            std::deque<std::function<void()>> tasks;//双向队列，任务可能被从尾部偷取
-            std::condition_variable cv;
-            std::mutex mtx;
+            WorkStealingDeque<Task*> tasks;//拥有者从底部取，其他线程从顶部窃取
         };
-        
+
         std::vector<std::thread> workers;//工作线程
-        std::vector<localQueue> taskQueue;//工作队列
-        bool stop;
+        std::vector<std::unique_ptr<localQueue>> taskQueue;//每个线程的本地队列
+
+        struct Injector
+        {
+            std::deque<Task*> tasks;//外部提交（或指定节点）的任务
+            std::mutex mtx;
+            std::atomic<size_t> size{0};
+        };
+
+        // 每个线程的窃取顺序：其他线程按距离分层排列，tierEnds[k] 为第 k 层的结束位置
+        struct StealOrder
+        {
+            std::vector<int> victims;
+            std::vector<int> tierEnds;
+        };
+
+        std::vector<std::unique_ptr<Injector>> injectors;//每个 NUMA 节点一个注入队列
+        std::atomic<size_t> injectorSize;//所有注入队列的任务总数
+        std::vector<int> workerCpu;//每个线程绑定的 CPU（未绑定为 -1）
+        std::vector<int> workerNode;//每个线程所在的节点
+        std::vector<StealOrder> stealOrder;
+
+        std::mutex sleepMtx;//休眠/唤醒
+        std::condition_variable sleepCv;
+        std::atomic<int> sleepers;//正在休眠（或准备休眠）的线程数
+        uint64_t wakeEpoch;//每次唤醒递增，受 sleepMtx 保护
+
+        std::atomic<bool> stop;
         int localSize;//线程数量
-    
+
+        static constexpr int kSpinRounds = 64;//休眠前的自旋轮数
+
+        // 当前线程所属的线程池及其本地队列序号（非工作线程为 nullptr / -1）
+        static ThreadPool*& currentPool(){ static thread_local ThreadPool* pool = nullptr; return pool; }
+        static int& currentIndex(){ static thread_local int index = -1; return index; }
+
+        // node < 0 表示不指定节点：工作线程放入自己的队列，外部线程放入调用者所在节点的注入队列
+        void push(Task* task, int node = -1){
+            if(currentPool() == this && (node < 0 || node == workerNode[currentIndex()])){//放入自己的队列底部
+                taskQueue[currentIndex()]->tasks.push(task);
+            }else{
+                if(node < 0) node = Topology::system().nodeOf(Topology::currentCpu());
+                Injector& injector = *injectors[static_cast<size_t>(node) % injectors.size()];
+                std::lock_guard<std::mutex> lock(injector.mtx);
+                injector.tasks.push_back(task);
+                injector.size.fetch_add(1, std::memory_order_relaxed);
+                injectorSize.fetch_add(1, std::memory_order_relaxed);
+            }
+            wakeOne();
+        }
+
+        void wakeOne(){
+            // 与 park() 中的 fence 配对：要么工作线程看到新任务，要么这里看到休眠者
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(sleepers.load(std::memory_order_relaxed) > 0){
+                {
+                    std::lock_guard<std::mutex> lock(sleepMtx);
+                    ++wakeEpoch;
+                }
+                sleepCv.notify_one();
+            }
+        }
+
+        Task* popInjector(Injector& injector){
+            if(injector.size.load(std::memory_order_relaxed) == 0) return nullptr;
+            std::lock_guard<std::mutex> lock(injector.mtx);
+            if(injector.tasks.empty()) return nullptr;
+            Task* task = injector.tasks.front();
+            injector.tasks.pop_front();
+            injector.size.fetch_sub(1, std::memory_order_relaxed);
+            injectorSize.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        }
+
+        // 本节点的注入队列（remote 为 true 时改为依次尝试其他节点的）
+        Task* popInjector(int i, bool remote){
+            if(injectorSize.load(std::memory_order_relaxed) == 0) return nullptr;
+            size_t home = static_cast<size_t>(workerNode[i]) % injectors.size();
+            if(!remote) return popInjector(*injectors[home]);
+            for(size_t k = 1;k < injectors.size();k++){
+                if(Task* task = popInjector(*injectors[(home + k) % injectors.size()])) return task;
+            }
+            return nullptr;
+        }
+
+        Task* findTask(int i, uint64_t& seed){
+            Task* task = nullptr;
+            if(taskQueue[i]->tasks.pop(task)) return task;//1. 自己的队列
+            if((task = popInjector(i, false))) return task;//2. 本节点的注入队列
+            //3. 按距离由近到远窃取，同一层内从随机位置开始；跨节点窃取前先看其他节点的注入队列
+            const StealOrder& order = stealOrder[i];
+            bool remoteInjectorsTried = false;
+            int tierBegin = 0;
+            for(int tierEnd:order.tierEnds){
+                if(!remoteInjectorsTried && workerNode[order.victims[tierBegin]] != workerNode[i]){
+                    remoteInjectorsTried = true;
+                    if((task = popInjector(i, true))) return task;
+                }
+                seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+                int width = tierEnd - tierBegin;
+                int start = static_cast<int>(seed % static_cast<uint64_t>(width));
+                for(int k = 0;k < width;k++){
+                    int victim = order.victims[tierBegin + (start + k) % width];
+                    if(taskQueue[victim]->tasks.steal(task)) return task;
+                }
+                tierBegin = tierEnd;
+            }
+            if(!remoteInjectorsTried) task = popInjector(i, true);
+            return task;
+        }
+
+        // 按绑定的 CPU 计算每个线程的窃取顺序；未绑核时所有线程同属一层（等价于随机窃取）
+        void buildStealOrder(){
+            const Topology& topology = Topology::system();
+            stealOrder.resize(localSize);
+            for(int i = 0;i < localSize;i++){
+                std::vector<std::pair<int, int>> byDistance;//(距离, 线程)
+                for(int j = 0;j < localSize;j++){
+                    if(j == i) continue;
+                    int distance = workerCpu[i] < 0 || workerCpu[j] < 0
+                        ? static_cast<int>(Topology::SameNode)
+                        : static_cast<int>(topology.distance(workerCpu[i], workerCpu[j]));
+                    byDistance.emplace_back(distance, j);
+                }
+                std::sort(byDistance.begin(), byDistance.end());
+                StealOrder& order = stealOrder[i];
+                for(size_t k = 0;k < byDistance.size();k++){
+                    order.victims.push_back(byDistance[k].second);
+                    if(k + 1 == byDistance.size() || byDistance[k + 1].first != byDistance[k].first){
+                        order.tierEnds.push_back(static_cast<int>(k + 1));
+                    }
+                }
+            }
+        }
+
+        bool hasWork() const{
+            if(injectorSize.load(std::memory_order_relaxed) > 0) return true;
+            for(const auto& q:taskQueue){
+                if(!q->tasks.empty()) return true;
+            }
+            return false;
+        }
+
+        // 无任务时休眠；返回 false 表示线程池已停止且没有剩余任务
+        bool park(){
+            std::unique_lock<std::mutex> lock(sleepMtx);
+            sleepers.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(hasWork()){//登记休眠后再检查一次，避免丢失唤醒
+                sleepers.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+            if(stop.load()){
+                sleepers.fetch_sub(1, std::memory_order_relaxed);
+                return false;
+            }
+            uint64_t epoch = wakeEpoch;
+            sleepCv.wait(lock, [this, epoch]{return stop.load() || wakeEpoch != epoch;});
+            sleepers.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        void workerLoop(int i){
+            if(workerCpu[i] >= 0) Topology::pinCurrentThread(workerCpu[i]);
+            currentPool() = this;
+            currentIndex() = i;
+            uint64_t seed = 0x9E3779B97F4A7C15ull * (i + 1);
+            while(true){
+                Task* task = findTask(i, seed);
+                for(int spin = 0;!task && spin < kSpinRounds;spin++){//短暂自旋，避免频繁休眠/唤醒
+                    std::this_thread::yield();
+                    task = findTask(i, seed);
+                }
+                if(task){
+                    std::unique_ptr<Task> owned(task);
+                    (*owned)();
+                    continue;
+                }
+                if(!park()) return;
+            }
+        }
+
     public:
-        ThreadPool(int num):stop(false),localSize(num){
+        ThreadPool(int num, const CpuAffinity& affinity = CpuAffinity::none())
+            :injectorSize(0),sleepers(0),wakeEpoch(0),stop(false),localSize(num){
+            if(num <= 0) throw std::invalid_argument("ThreadPool needs at least one worker");
             for(int i = 0;i < num;i++){
-                
-                    workers.emplace_back([this,i]{
-                        while(true){
-                        {   
-                            std::function<void()> task;
-                            std::unique_lock<std::mutex> lock(this->taskQueue[i].mtx);//给自己的任务队列加锁
-                            bool notified = taskQueue[i].cv.wait_for(lock,std::chrono::milliseconds(0),[this,i]{
-                                return stop || !taskQueue[i].tasks.empty();
-                            });/*立即检查自己的队列是否为空，如果不为空，则继续持有自己队列的锁并执行任务；
-                                否则释放自己队列的锁，且不阻塞
-                            */
-                           if(notified){//自己的任务队列不为空
-                                if(stop && taskQueue[i].tasks.empty()){
-                                    return;
-                                }
-                                if(!taskQueue[i].tasks.empty()){
-                                    task = std::move(taskQueue[i].tasks.front());
-                                    taskQueue[i].tasks.pop_front();
-                                }
-                           }else{//自己的任务队列为空且并未出现停止信号，则偷取任务
-                                while (!taskQueue[i].cv.wait_for(lock,std::chrono::milliseconds(0),[this,i]{return stop || !taskQueue[i].tasks.empty();}))
-                                //自己的任务队列一直为空才会一直循环想要偷取任务，否则循环结束
-                                {   
-                                    int num = std::rand() % localSize;//随机取其他线程序号
-                                    std::unique_lock<std::mutex> lock(taskQueue[num].mtx,std::try_to_lock);//尝试加锁
-                                    if(lock.owns_lock()){//加锁成功
-                                        if(!taskQueue[num].tasks.empty()){//有任务可以窃取
-                                            task = std::move(taskQueue[num].tasks.back());//从尾部窃取
-                                            taskQueue[num].tasks.pop_back();
-                                        }
-                                    }else{//加锁失败
-                                        std::this_thread::sleep_for(std::chrono::milliseconds(200));//等待200ms，防止一直轮询
-                                        continue;
-                                    }
-                                }
-                           }
-                           if(task){task();}
-                           
-                        }
-                    }
-                    });
-                    
-                
+                taskQueue.emplace_back(new localQueue);
+            }
+            const Topology& topology = Topology::system();
+            workerCpu = affinity.resolve(num);
+            for(int cpu:workerCpu){
+                workerNode.push_back(cpu < 0 ? 0 : topology.nodeOf(cpu));
+            }
+            for(size_t node = 0;node < topology.nodeCount();node++){
+                injectors.emplace_back(new Injector);
+            }
+            buildStealOrder();
+            for(int i = 0;i < num;i++){
+                workers.emplace_back([this,i]{workerLoop(i);});
+            }
+        }
+
+        template<class F,class ...Args>
+        auto enqueue(F&&f,Args&&...args)->std::future<std::invoke_result_t<F, Args...>>{
+            using return_type = std::invoke_result_t<F, Args...>;
+            auto task = std::make_shared<std::packaged_task<return_type()>>(
+                std::bind(std::forward<F>(f), std::forward<Args>(args)...)
+            );
+            std::future<return_type> res = task->get_future();
+            if(stop.load()){
+                throw std::runtime_error("enqueue on stopped ThreadPool");
+            }
+            push(new Task([task]{(*task)();}));
+            return res;
+        }
+
+        // 带节点提示提交：任务放入该 NUMA 节点的注入队列，优先由该节点上的线程执行；
+        // node < 0 表示不指定，与 enqueue 相同（工作线程放入自己的队列，外部线程放入所在节点的注入队列）
+        template<class F,class ...Args>
+        auto enqueue_on(int node,F&&f,Args&&...args)->std::future<std::invoke_result_t<F, Args...>>{
+            using return_type = std::invoke_result_t<F, Args...>;
+            auto task = std::make_shared<std::packaged_task<return_type()>>(
+                std::bind(std::forward<F>(f), std::forward<Args>(args)...)
+            );
+            std::future<return_type> res = task->get_future();
+            if(stop.load()){
+                throw std::runtime_error("enqueue on stopped ThreadPool");
             }
+            push(new Task([task]{(*task)();}), node);
+            return res;
         }
 
-};
\ No newline at end of file
+        ~ThreadPool(){
+            {
+                std::lock_guard<std::mutex> lock(sleepMtx);
+                stop = true;
+                ++wakeEpoch;
+            }
+            sleepCv.notify_all();
+            for(auto& worker:workers){
+                worker.join();
+            }
+        }
+};
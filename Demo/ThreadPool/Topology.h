@@ -0,0 +1,230 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+/*
+ **************** CPU 拓扑与线程绑核 ****************
+ 设计目标：
+    1. 从 sysfs 读取每个逻辑 CPU 所属的物理核、末级缓存（LLC）、NUMA 节点
+       （/sys/devices/system/cpu/cpuN/topology、cache/indexK、/sys/devices/system/node/nodeM/cpulist）
+    2. 给出两个逻辑 CPU 之间的"距离"：同一 CPU < 同一物理核 < 同一 LLC < 同一节点 < 跨节点，
+       供工作窃取按由近到远的顺序选择窃取对象
+    3. placement(n)：为 n 个工作线程挑选 CPU，先占满每个物理核的第一个超线程，再用兄弟超线程，按节点聚集
+    4. 读不到 sysfs（非 Linux 或容器限制）时退化为"每个 CPU 独立成核、单节点"，绑核失败只返回 false
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+struct CpuInfo {
+    int cpu = 0;        // 逻辑 CPU 编号
+    int core = 0;       // 物理核（全局唯一编号）
+    int llc = 0;        // 末级缓存分组
+    int node = 0;       // NUMA 节点
+    int smtIndex = 0;   // 在所属物理核中的超线程序号（0 为第一个）
+};
+
+class Topology {
+public:
+    enum Distance {
+        SameCpu = 0,
+        SameCore = 1,
+        SameCache = 2,
+        SameNode = 3,
+        Remote = 4
+    };
+
+    // 读取本机拓扑
+    static const Topology& system() {
+        static const Topology topology = detect();
+        return topology;
+    }
+
+    // 解析 "0-3,8,10-11" 形式的 CPU 列表
+    static std::vector<int> parseCpuList(const std::string& text) {
+        std::vector<int> cpus;
+        std::stringstream ss(text);
+        std::string part;
+        while (std::getline(ss, part, ',')) {
+            part.erase(std::remove_if(part.begin(), part.end(), [](char c) { return c == ' ' || c == '\n'; }), part.end());
+            if (part.empty()) continue;
+            size_t dash = part.find('-');
+            int first = std::stoi(part.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(part.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+
+    const std::vector<CpuInfo>& cpus() const { return cpus_; }
+    size_t nodeCount() const { return nodeCount_; }   // 最大节点编号 + 1（节点编号可能不连续）
+
+    // 逻辑 CPU 的信息；未知的 CPU 返回 nullptr
+    const CpuInfo* find(int cpu) const {
+        auto it = index_.find(cpu);
+        return it == index_.end() ? nullptr : &cpus_[it->second];
+    }
+
+    int nodeOf(int cpu) const {
+        const CpuInfo* info = find(cpu);
+        return info ? info->node : 0;
+    }
+
+    Distance distance(int a, int b) const {
+        if (a == b) return SameCpu;
+        const CpuInfo* x = find(a);
+        const CpuInfo* y = find(b);
+        if (!x || !y) return Remote;
+        if (x->core == y->core) return SameCore;
+        if (x->llc == y->llc) return SameCache;
+        if (x->node == y->node) return SameNode;
+        return Remote;
+    }
+
+    // 为 n 个线程挑选 CPU：按节点、LLC 聚集，先用每个物理核的第一个超线程；n 超过 CPU 数时循环使用
+    std::vector<int> placement(size_t n) const {
+        std::vector<CpuInfo> order = cpus_;
+        std::sort(order.begin(), order.end(), [](const CpuInfo& a, const CpuInfo& b) {
+            if (a.smtIndex != b.smtIndex) return a.smtIndex < b.smtIndex;
+            if (a.node != b.node) return a.node < b.node;
+            if (a.llc != b.llc) return a.llc < b.llc;
+            return a.cpu < b.cpu;
+        });
+        std::vector<int> result;
+        for (size_t i = 0; i < n && !order.empty(); ++i) {
+            result.push_back(order[i % order.size()].cpu);
+        }
+        return result;
+    }
+
+    // 把当前线程绑定到 cpu；不支持或失败时返回 false
+    static bool pinCurrentThread(int cpu) {
+#if defined(__linux__)
+        if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
+
+    // 当前线程正在运行的 CPU；未知时返回 -1
+    static int currentCpu() {
+#if defined(__linux__)
+        return sched_getcpu();
+#else
+        return -1;
+#endif
+    }
+
+private:
+    static std::string readFile(const std::string& path) {
+        std::ifstream in(path);
+        std::string text;
+        std::getline(in, text);
+        return text;
+    }
+
+    static int readInt(const std::string& path, int fallback) {
+        std::string text = readFile(path);
+        if (text.empty()) return fallback;
+        try {
+            return std::stoi(text);
+        } catch (...) {
+            return fallback;
+        }
+    }
+
+    static Topology detect() {
+        Topology topology;
+        const std::string base = "/sys/devices/system/cpu/";
+        std::vector<int> online = parseCpuList(readFile(base + "online"));
+        if (online.empty()) {
+            for (unsigned i = 0; i < std::max(1u, std::thread::hardware_concurrency()); ++i) online.push_back(i);
+        }
+
+        // NUMA 节点：node 目录下各节点的 cpulist
+        std::map<int, int> nodeOfCpu;
+        std::vector<int> nodes = parseCpuList(readFile("/sys/devices/system/node/online"));
+        for (int node : nodes) {
+            for (int cpu : parseCpuList(readFile("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"))) {
+                nodeOfCpu[cpu] = node;
+            }
+        }
+
+        std::map<std::pair<int, int>, int> coreIds;     // (package, core_id) -> 全局核编号
+        std::map<std::string, int> llcIds;              // LLC 的 shared_cpu_list -> 分组编号
+        std::map<int, int> smtCount;                    // 物理核 -> 已见到的超线程数
+        for (int cpu : online) {
+            std::string dir = base + "cpu" + std::to_string(cpu) + "/";
+            CpuInfo info;
+            info.cpu = cpu;
+            int package = readInt(dir + "topology/physical_package_id", 0);
+            int coreId = readInt(dir + "topology/core_id", cpu);
+            auto core = coreIds.emplace(std::make_pair(package, coreId), static_cast<int>(coreIds.size())).first;
+            info.core = core->second;
+            info.smtIndex = smtCount[info.core]++;
+            info.node = nodeOfCpu.count(cpu) ? nodeOfCpu[cpu] : 0;
+
+            // 末级缓存：level 最大的 cache/indexK，用共享它的 CPU 列表作为分组键
+            int bestLevel = -1;
+            std::string shared;
+            for (int k = 0; k < 8; ++k) {
+                std::string cache = dir + "cache/index" + std::to_string(k) + "/";
+                int level = readInt(cache + "level", -1);
+                if (level < 0) break;
+                if (level > bestLevel) {
+                    bestLevel = level;
+                    shared = readFile(cache + "shared_cpu_list");
+                }
+            }
+            if (shared.empty()) shared = "node" + std::to_string(info.node);
+            info.llc = llcIds.emplace(shared, static_cast<int>(llcIds.size())).first->second;
+
+            topology.index_[cpu] = topology.cpus_.size();
+            topology.cpus_.push_back(info);
+        }
+        for (const CpuInfo& info : topology.cpus_) {
+            topology.nodeCount_ = std::max(topology.nodeCount_, static_cast<size_t>(info.node) + 1);
+        }
+        return topology;
+    }
+
+    std::vector<CpuInfo> cpus_;
+    std::map<int, size_t> index_;    // 逻辑 CPU -> cpus_ 下标
+    size_t nodeCount_ = 1;
+};
+
+// 线程池的绑核选项：不绑定 / 按检测到的拓扑自动挑选 / 按给定的 CPU 列表（第 i 个线程用 cpus[i % size]）
+struct CpuAffinity {
+    bool pin = false;
+    std::vector<int> cpus;     // 为空且 pin 为 true 时按拓扑挑选
+
+    static CpuAffinity none() { return CpuAffinity(); }
+    static CpuAffinity topology() { return CpuAffinity{true, {}}; }
+    static CpuAffinity list(std::vector<int> cpus) { return CpuAffinity{true, std::move(cpus)}; }
+    static CpuAffinity list(const std::string& cpuList) { return list(Topology::parseCpuList(cpuList)); }
+
+    // 为 n 个线程给出各自的 CPU；不绑定时返回全 -1
+    std::vector<int> resolve(size_t n) const {
+        if (!pin) return std::vector<int>(n, -1);
+        std::vector<int> source = cpus.empty() ? Topology::system().placement(n) : cpus;
+        std::vector<int> result(n, -1);
+        for (size_t i = 0; i < n && !source.empty(); ++i) result[i] = source[i % source.size()];
+        return result;
+    }
+};
+
+#endif // TOPOLOGY_H
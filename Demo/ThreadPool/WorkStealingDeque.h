@@ -0,0 +1,131 @@
+#ifndef WORK_STEALING_DEQUE_H
+#define WORK_STEALING_DEQUE_H
+
+/*
+ **************** Chase-Lev 工作窃取双端队列 ****************
+ 参考：Lê, Pop, Cohen, Zappa Nardelli,
+      "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP'13)
+ 设计目标：
+    1. 拥有者线程在底部 push / pop（LIFO，缓存局部性好），无锁且通常无 CAS
+    2. 窃取者线程在顶部 steal（FIFO），仅在与其他线程竞争同一元素时使用 CAS
+    3. 环形数组满时自动扩容；旧数组保留到析构，窃取者读取旧数组依然安全
+    4. 元素类型需可平凡拷贝（通常存放任务指针）
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+template<typename T>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque requires trivially copyable elements");
+
+    // 容量为 2 的幂的环形数组，下标用掩码取模
+    struct Array {
+        explicit Array(size_t cap) : capacity(cap), mask(cap - 1), slots(new std::atomic<T>[cap]) {}
+
+        T get(int64_t i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T value) { slots[i & mask].store(value, std::memory_order_relaxed); }
+
+        // 扩容为两倍，复制 [top, bottom) 区间的元素
+        Array* grow(int64_t top, int64_t bottom) const {
+            Array* bigger = new Array(capacity * 2);
+            for (int64_t i = top; i < bottom; ++i) {
+                bigger->put(i, get(i));
+            }
+            return bigger;
+        }
+
+        size_t capacity;
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+public:
+    explicit WorkStealingDeque(size_t capacity = 256) : top_(0), bottom_(0) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        Array* initial = new Array(cap);
+        arrays_.emplace_back(initial);
+        array_.store(initial, std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // 拥有者线程：压入底部
+    void push(T item) {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_acquire);
+        Array* a = array_.load(std::memory_order_relaxed);
+        if (b - t > static_cast<int64_t>(a->capacity) - 1) {
+            a = a->grow(t, b);
+            arrays_.emplace_back(a);   // 只有拥有者会修改 arrays_
+            array_.store(a, std::memory_order_release);
+        }
+        a->put(b, item);
+        bottom_.store(b + 1, std::memory_order_release);   // 与 steal() 中对 bottom_ 的 acquire 配对，发布元素
+    }
+
+    // 拥有者线程：从底部弹出，队列为空（或最后一个元素被窃取）时返回 false
+    bool pop(T& out) {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Array* a = array_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+
+        if (t > b) {    // 队列为空，恢复 bottom
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        T item = a->get(b);
+        if (t == b) {   // 只剩最后一个元素，与窃取者竞争
+            bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            if (!won) return false;
+        }
+        out = item;
+        return true;
+    }
+
+    // 任意线程：从顶部窃取，队列为空或竞争失败时返回 false
+    bool steal(T& out) {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) return false;
+
+        Array* a = array_.load(std::memory_order_acquire);
+        T item = a->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return false;
+        }
+        out = item;
+        return true;
+    }
+
+    // 近似判断（并发下仅作为提示）
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t size() const {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> top_;      // 窃取端（与 bottom_ 分属不同缓存行，避免伪共享）
+    alignas(64) std::atomic<int64_t> bottom_;   // 拥有者端
+    std::atomic<Array*> array_;                 // 当前环形数组
+    std::vector<std::unique_ptr<Array>> arrays_; // 所有分配过的数组（延迟回收）
+};
+
+#endif // WORK_STEALING_DEQUE_H
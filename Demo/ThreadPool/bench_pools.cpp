@@ -0,0 +1,357 @@
+/*
+ **************** 线程池对比基准 ****************
+ 设计目标：
+    1. 用同一套负载比较本仓库的五种线程池实现：
+       header   - ThreadPool.h（单一共享队列 + 条件变量）
+       shared   - ThreadPool_sharedQueue.cpp（共享队列，enqueue 返回 future）
+       multi    - ThreadPool_mulitQueue.cpp（每线程一个队列，二选一投递 + 从兄弟队列取任务）
+       steal    - ThreadPool_steal.cpp（Chase-Lev 本地队列 + 注入队列 + 工作窃取）
+       download - ../DownloadTool/ThreadPool.h（有界 MPMC 队列、优先级通道、弹性线程数）
+    2. 五类负载：
+       empty    - 主线程连续提交空任务，测量纯调度开销
+       skewed   - 任务耗时长尾分布（89% 2us、10% 20us、1% 200us），考察负载不均时的调度
+       forkjoin - 递归二叉分解：每个任务在工作线程内再提交两个子任务，叶子做 1us 计算，
+                  全部叶子完成即汇合（计数汇合，不在工作线程中阻塞等待，各实现都不会死锁）
+       producer - 4 个外部线程同时提交空任务，考察提交端竞争
+       bursty   - 每批 256 个 5us 任务，批间空闲 2ms，考察线程休眠后的唤醒延迟
+    3. 线程数从 1 开始按 2 的幂增加到 --threads（默认为 CPU 数，最后一档总是 --threads 本身）
+    4. 每个任务记录"提交 -> 开始执行"的延迟，给出 p50/p99/p999/max（精确分位数，非直方图近似），
+       吞吐量 = 任务数 / 从第一次提交到最后一个任务完成的时间
+    5. 默认输出 CSV（一行一个 pool × workload × threads 组合），--json 输出 JSON 数组，便于脚本处理
+ 编译：g++ -std=c++17 -O2 -pthread bench_pools.cpp -o bench_pools
+ 用法：./bench_pools [--threads N] [--scale X] [--pools header,steal,...] [--workloads empty,bursty,...] [--json]
+*/
+
+// 先在全局作用域包含各实现用到的全部头文件：下面把各实现 #include 进各自的命名空间时，
+// 这些头文件因包含保护展开为空，同名的 ThreadPool 类就互不冲突
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "Topology.h"
+#include "WorkStealingDeque.h"
+#include "../DownloadTool/ThreadPool.h"
+
+namespace header_pool {
+#include "ThreadPool.h"
+}
+namespace shared_queue {
+#include "ThreadPool_sharedQueue.cpp"
+}
+namespace multi_queue {
+#include "ThreadPool_mulitQueue.cpp"
+}
+namespace steal_pool {
+#include "ThreadPool_steal.cpp"
+}
+using DownloadPool = ::ThreadPool;
+
+using Clock = std::chrono::steady_clock;
+
+static uint64_t nanosSince(Clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+// 忙等 ns 纳秒，模拟计算型任务
+static void spinFor(uint64_t ns) {
+    if (ns == 0) return;
+    auto start = Clock::now();
+    while (nanosSince(start) < ns) {
+    }
+}
+
+// 统一的提交接口：各实现只需提供 create / submit 两个重载；返回的 future 直接丢弃，完成情况由 Run 计数
+static std::unique_ptr<header_pool::ThreadPool> create(header_pool::ThreadPool*, size_t threads) {
+    return std::make_unique<header_pool::ThreadPool>(threads);
+}
+static std::unique_ptr<shared_queue::ThreadPool> create(shared_queue::ThreadPool*, size_t threads) {
+    return std::make_unique<shared_queue::ThreadPool>(static_cast<int>(threads));
+}
+static std::unique_ptr<multi_queue::ThreadPool> create(multi_queue::ThreadPool*, size_t threads) {
+    return std::make_unique<multi_queue::ThreadPool>(static_cast<int>(threads));
+}
+static std::unique_ptr<steal_pool::ThreadPool> create(steal_pool::ThreadPool*, size_t threads) {
+    return std::make_unique<steal_pool::ThreadPool>(static_cast<int>(threads));
+}
+static std::unique_ptr<DownloadPool> create(DownloadPool*, size_t threads) {
+    DownloadPool::Options options;
+    options.coreThreads = threads;
+    options.maxThreads = threads;
+    options.queueCapacity = 1 << 16;
+    options.rejectPolicy = DownloadPool::RejectPolicy::CallerRuns;   // 工作线程递归提交时队列满也不会互相阻塞
+    return std::make_unique<DownloadPool>(options);
+}
+
+template<typename F> void submit(header_pool::ThreadPool& pool, F&& f) { pool.submit(std::forward<F>(f)); }
+template<typename F> void submit(shared_queue::ThreadPool& pool, F&& f) { pool.enqueue(std::forward<F>(f)); }
+template<typename F> void submit(multi_queue::ThreadPool& pool, F&& f) { pool.enqueue(std::forward<F>(f)); }
+template<typename F> void submit(steal_pool::ThreadPool& pool, F&& f) { pool.enqueue(std::forward<F>(f)); }
+template<typename F> void submit(DownloadPool& pool, F&& f) { pool.post(std::forward<F>(f)); }
+
+// 一次测量的共享状态：每个任务占一个延迟槽位，最后一个完成的任务唤醒主线程
+struct Run {
+    explicit Run(size_t tasks) : latency(tasks), remaining(tasks) {}
+
+    // 任务开始执行时调用，记录提交 -> 开始的延迟
+    void started(Clock::time_point submittedAt) {
+        size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+        latency[slot] = nanosSince(submittedAt);
+    }
+
+    void finished() {
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(mtx);
+            done = true;
+            cv.notify_one();
+        }
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [this] { return done; });
+    }
+
+    std::vector<uint64_t> latency;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> remaining;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool done = false;
+};
+
+struct Result {
+    std::string pool;
+    std::string workload;
+    size_t threads = 0;
+    size_t tasks = 0;
+    double seconds = 0;
+    uint64_t p50 = 0, p99 = 0, p999 = 0, max = 0;
+};
+
+static uint64_t percentile(std::vector<uint64_t>& values, double q) {
+    if (values.empty()) return 0;
+    size_t k = std::min(values.size() - 1, static_cast<size_t>(q * static_cast<double>(values.size())));
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(k), values.end());
+    return values[k];
+}
+
+// 递归二叉分解：depth 为 0 的节点是叶子
+template<typename Pool>
+struct ForkJoinNode {
+    Pool* pool;
+    Run* run;
+    int depth;
+    Clock::time_point submittedAt;
+
+    void operator()() const {
+        run->started(submittedAt);
+        if (depth == 0) {
+            spinFor(1000);
+        } else {
+            auto now = Clock::now();
+            submit(*pool, ForkJoinNode{pool, run, depth - 1, now});
+            submit(*pool, ForkJoinNode{pool, run, depth - 1, now});
+        }
+        run->finished();
+    }
+};
+
+struct Workloads {
+    size_t emptyTasks;
+    size_t skewedTasks;
+    int forkDepth;
+    size_t producerTasks;
+    size_t producers;
+    size_t bursts;
+    size_t burstSize;
+    std::chrono::milliseconds burstGap;
+
+    explicit Workloads(double scale)
+        : emptyTasks(scaled(200000, scale)), skewedTasks(scaled(20000, scale)),
+          forkDepth(std::max(1, static_cast<int>(15 + std::log2(std::max(scale, 1.0 / 16384))))),
+          producerTasks(scaled(200000, scale)), producers(4), bursts(scaled(50, scale)), burstSize(256),
+          burstGap(2) {}
+
+    static size_t scaled(size_t base, double scale) {
+        return std::max<size_t>(1, static_cast<size_t>(static_cast<double>(base) * scale));
+    }
+
+    size_t taskCount(const std::string& name) const {
+        if (name == "empty") return emptyTasks;
+        if (name == "skewed") return skewedTasks;
+        if (name == "forkjoin") return (size_t(1) << (forkDepth + 1)) - 1;
+        if (name == "producer") return producerTasks / producers * producers;
+        if (name == "bursty") return bursts * burstSize;
+        throw std::invalid_argument("unknown workload: " + name);
+    }
+};
+
+// 跑一次 pool × workload × threads，返回计时与延迟分位数；线程池在计时外创建和销毁
+template<typename Pool>
+Result runOne(const std::string& poolName, const std::string& workload, size_t threads, const Workloads& w) {
+    auto pool = create(static_cast<Pool*>(nullptr), threads);
+    size_t tasks = w.taskCount(workload);
+    Run run(tasks);
+    Run* r = &run;
+
+    auto start = Clock::now();
+    if (workload == "empty") {
+        for (size_t i = 0; i < tasks; ++i) {
+            auto at = Clock::now();
+            submit(*pool, [r, at] { r->started(at); r->finished(); });
+        }
+    } else if (workload == "skewed") {
+        for (size_t i = 0; i < tasks; ++i) {
+            uint64_t cost = i % 100 == 0 ? 200000 : (i % 10 == 0 ? 20000 : 2000);
+            auto at = Clock::now();
+            submit(*pool, [r, at, cost] { r->started(at); spinFor(cost); r->finished(); });
+        }
+    } else if (workload == "forkjoin") {
+        submit(*pool, ForkJoinNode<Pool>{pool.get(), r, w.forkDepth, Clock::now()});
+    } else if (workload == "producer") {
+        size_t perProducer = tasks / w.producers;
+        std::vector<std::thread> producers;
+        for (size_t p = 0; p < w.producers; ++p) {
+            producers.emplace_back([&pool, r, perProducer] {
+                for (size_t i = 0; i < perProducer; ++i) {
+                    auto at = Clock::now();
+                    submit(*pool, [r, at] { r->started(at); r->finished(); });
+                }
+            });
+        }
+        for (auto& producer : producers) producer.join();
+    } else if (workload == "bursty") {
+        for (size_t b = 0; b < w.bursts; ++b) {
+            for (size_t i = 0; i < w.burstSize; ++i) {
+                auto at = Clock::now();
+                submit(*pool, [r, at] { r->started(at); spinFor(5000); r->finished(); });
+            }
+            std::this_thread::sleep_for(w.burstGap);
+        }
+    }
+    run.wait();
+
+    Result result;
+    result.pool = poolName;
+    result.workload = workload;
+    result.threads = threads;
+    result.tasks = tasks;
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.p50 = percentile(run.latency, 0.5);
+    result.p99 = percentile(run.latency, 0.99);
+    result.p999 = percentile(run.latency, 0.999);
+    result.max = *std::max_element(run.latency.begin(), run.latency.end());
+    return result;
+}
+
+static Result runPool(const std::string& pool, const std::string& workload, size_t threads, const Workloads& w) {
+    if (pool == "header") return runOne<header_pool::ThreadPool>(pool, workload, threads, w);
+    if (pool == "shared") return runOne<shared_queue::ThreadPool>(pool, workload, threads, w);
+    if (pool == "multi") return runOne<multi_queue::ThreadPool>(pool, workload, threads, w);
+    if (pool == "steal") return runOne<steal_pool::ThreadPool>(pool, workload, threads, w);
+    if (pool == "download") return runOne<DownloadPool>(pool, workload, threads, w);
+    throw std::invalid_argument("unknown pool: " + pool);
+}
+
+static std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+static void printResult(const Result& r, bool json, bool first) {
+    double rate = r.seconds > 0 ? static_cast<double>(r.tasks) / r.seconds : 0.0;
+    if (json) {
+        std::printf("%s\n  {\"pool\":\"%s\",\"workload\":\"%s\",\"threads\":%zu,\"tasks\":%zu,\"seconds\":%.6f,"
+                    "\"tasks_per_sec\":%.0f,\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,\"max_ns\":%llu}",
+                    first ? "" : ",", r.pool.c_str(), r.workload.c_str(), r.threads, r.tasks, r.seconds, rate,
+                    static_cast<unsigned long long>(r.p50), static_cast<unsigned long long>(r.p99),
+                    static_cast<unsigned long long>(r.p999), static_cast<unsigned long long>(r.max));
+    } else {
+        std::printf("%s,%s,%zu,%zu,%.6f,%.0f,%llu,%llu,%llu,%llu\n", r.pool.c_str(), r.workload.c_str(), r.threads,
+                    r.tasks, r.seconds, rate, static_cast<unsigned long long>(r.p50),
+                    static_cast<unsigned long long>(r.p99), static_cast<unsigned long long>(r.p999),
+                    static_cast<unsigned long long>(r.max));
+    }
+    std::fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    double scale = 1.0;
+    bool json = false;
+    std::vector<std::string> pools = {"header", "shared", "multi", "steal", "download"};
+    std::vector<std::string> workloads = {"empty", "skewed", "forkjoin", "producer", "bursty"};
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--threads" && hasValue) {
+            maxThreads = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--scale" && hasValue) {
+            scale = std::max(1e-4, std::atof(argv[++i]));
+        } else if (arg == "--pools" && hasValue) {
+            pools = splitList(argv[++i]);
+        } else if (arg == "--workloads" && hasValue) {
+            workloads = splitList(argv[++i]);
+        } else if (arg == "--json") {
+            json = true;
+        } else {
+            std::fprintf(stderr,
+                         "usage: %s [--threads N] [--scale X] [--pools header,shared,multi,steal,download] "
+                         "[--workloads empty,skewed,forkjoin,producer,bursty] [--json]\n",
+                         argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<size_t> threadCounts;
+    for (size_t n = 1; n < maxThreads; n *= 2) threadCounts.push_back(n);
+    threadCounts.push_back(maxThreads);
+
+    Workloads w(scale);
+    if (json) {
+        std::printf("[");
+    } else {
+        std::printf("pool,workload,threads,tasks,seconds,tasks_per_sec,p50_ns,p99_ns,p999_ns,max_ns\n");
+    }
+    bool first = true;
+    try {
+        for (const auto& workload : workloads) {
+            for (size_t threads : threadCounts) {
+                for (const auto& pool : pools) {
+                    printResult(runPool(pool, workload, threads, w), json, first);
+                    first = false;
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "bench_pools: %s\n", e.what());
+        return 1;
+    }
+    if (json) std::printf("\n]\n");
+    return 0;
+}